@@ -1,5 +1,7 @@
 #pragma once
 #include <cmath>
+#include <cstdint>
+#include <type_traits>
 #include <algorithm>
 #include <tuple>
 #include <deque>
@@ -57,6 +59,8 @@ namespace Sc2Bindings
 		Point(T _x, T _y) : x(_x), y(_y) {}
 
 		/// <summary>A copy constructor for positions with different underlying types.</summary>
+		/// It is implicit when \p T is a floating point type (e.g. WalkCoord to WalkPosition),
+		/// and explicit otherwise, as the conversion may then truncate (e.g. WalkPosition to WalkCoord).
 		///
 		/// <param name="pt">
 		///     The Point to receive data from.
@@ -64,7 +68,11 @@ namespace Sc2Bindings
 		///
 		/// @tparam FromT
 		///     The type being converted to type T.
-		template<typename FromT> Point(const Point<FromT, Scale> &pt) : x(static_cast<T>(pt.x)), y(static_cast<T>(pt.y)) {}
+		template<typename FromT, typename ToT = T, typename std::enable_if<std::is_floating_point<ToT>::value, int>::type = 0>
+		Point(const Point<FromT, Scale> &pt) : x(static_cast<T>(pt.x)), y(static_cast<T>(pt.y)) {}
+		/// @overload
+		template<typename FromT, typename ToT = T, typename std::enable_if<!std::is_floating_point<ToT>::value, int>::type = 0>
+		explicit Point(const Point<FromT, Scale> &pt) : x(static_cast<T>(pt.x)), y(static_cast<T>(pt.y)) {}
 
 #pragma warning( push )
 #pragma warning( disable: 4723 )
@@ -439,7 +447,19 @@ namespace Sc2Bindings
 		const TilePosition Origin{ 0, 0 };
 	}
 
+	/// <summary>Compact, integral counterpart of @ref WalkPosition, used to index and store the MiniTile grid.</summary>
+	/// It takes 4 bytes instead of 8, and its arithmetic needs no floating point conversion.
+	/// It converts implicitly to a WalkPosition, while the reverse conversion (which truncates) must be explicit.
+	/// @see WalkPosition
+	typedef Sc2Bindings::Point<int16_t, WALKPOSITION_SCALE> WalkCoord;
+
+	/// <summary>Compact, integral counterpart of @ref TilePosition, used to index and store the Tile grid.</summary>
+	/// @see TilePosition, WalkCoord
+	typedef Sc2Bindings::Point<int16_t, TILEPOSITION_SCALE> TileCoord;
+
 	static_assert(sizeof(Position) == 8, "Expected BWAPI Position to be 8 bytes.");
 	static_assert(sizeof(TilePosition) == 8, "Expected BWAPI Position to be 8 bytes.");
 	static_assert(sizeof(WalkPosition) == 8, "Expected BWAPI Position to be 8 bytes.");
+	static_assert(sizeof(TileCoord) == 4, "Expected TileCoord to be 4 bytes.");
+	static_assert(sizeof(WalkCoord) == 4, "Expected WalkCoord to be 4 bytes.");
 }
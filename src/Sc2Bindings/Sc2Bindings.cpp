@@ -37,6 +37,26 @@ namespace Sc2Bindings
 		return NewPosition;
 	}
 
+	sc2::Point2D Point2DFromTileCoord(TileCoord t)
+	{
+		return sc2::Point2D(static_cast<float>(t.x), static_cast<float>(t.y));
+	}
+
+	sc2::Point2D Point2DFromWalkCoord(WalkCoord w)
+	{
+		return sc2::Point2D(w.x / 4.0f, w.y / 4.0f);
+	}
+
+	TileCoord TileCoordFromPoint2D(sc2::Point2D Position)
+	{
+		return TileCoord(static_cast<int16_t>(std::floor(Position.x)), static_cast<int16_t>(std::floor(Position.y)));
+	}
+
+	WalkCoord WalkCoordFromPoint2D(sc2::Point2D Position)
+	{
+		return WalkCoord(static_cast<int16_t>(std::floor(4 * Position.x)), static_cast<int16_t>(std::floor(4 * Position.y)));
+	}
+
 	TilePosition GetInitialTilePosition(sc2::Unit u)
 	{
 		TilePosition ReturnPos;
@@ -22,6 +22,13 @@ namespace Sc2Bindings
 
 	TilePosition TilePositionFromPoint2D(sc2::Point2D Position);
 
+	// Conversions between the compact grid coordinates and the world coordinates of the game (1 unit = 1 Tile = 4 MiniTiles).
+	// A grid coordinate is converted to the world position of its top left corner, and a world position to the cell that contains it.
+	sc2::Point2D Point2DFromTileCoord(TileCoord t);
+	sc2::Point2D Point2DFromWalkCoord(WalkCoord w);
+	TileCoord TileCoordFromPoint2D(sc2::Point2D Position);
+	WalkCoord WalkCoordFromPoint2D(sc2::Point2D Position);
+
 	TilePosition GetInitialTilePosition(sc2::Unit u);
 	
 	TilePosition GetSizeFromRadius(float radius);
@@ -28,6 +28,165 @@ using namespace Sc2Bindings;
 
 
 
+namespace detail {
+
+// Helper class for void Area::CreateBases()
+// The Potential Fields of the remaining Ressources of an Area (Cf. Area::CreateBases), restricted to the bounding box of the Area:
+// the footprint of a Command Center can only contain Tiles of the Area, so the Tiles outside that box never matter.
+// Each Area uses its own BaseLocationField, so that the Areas can create their Bases concurrently (Cf. Graph::CreateBases).
+// Once the Potentials are set, ComputeSums builds two summed-area tables, which give the score of most footprints in O(1) (Cf. Score).
+// Like the Potentials, the Tiles that are forbidden in the footprints are stored in the bounding box only.
+class BaseLocationField
+{
+public:
+						BaseLocationField(const Area * pArea)
+							: m_pMap(pArea->GetMap())
+							, m_mapWidth(static_cast<int>(m_pMap->Size().x))
+							, m_left(static_cast<int>(pArea->TopLeft().x))
+							, m_top(static_cast<int>(pArea->TopLeft().y))
+							, m_width(static_cast<int>(pArea->BottomRight().x) - m_left + 1)
+							, m_height(static_cast<int>(pArea->BottomRight().y) - m_top + 1)
+							, m_Potentials(m_width * m_height, 0)
+							, m_Forbidden(m_width * m_height)
+						{
+							// The Tiles that cannot be part of the footprint, whatever the Potentials (Cf. Score):
+							for (int y = 0 ; y < m_height ; ++y)
+							for (int x = 0 ; x < m_width ; ++x)
+							{
+								const Tile & tile = m_pMap->Tiles()[(m_top + y) * m_mapWidth + m_left + x];
+								m_Forbidden[y * m_width + x] = !tile.Buildable() || (tile.AreaId() != pArea->Id()) ||
+																(tile.GetNeutral() && tile.GetNeutral()->IsStaticBuilding());
+							}
+						}
+
+	// Returns the Potential of the Tile pMap->GetTile(t), or nullptr if that Tile is outside the bounding box of the Area.
+	int *				Potential(const TilePosition & t)		{ return const_cast<int *>(static_cast<const BaseLocationField &>(*this).Potential(t)); }
+	const int *			Potential(const TilePosition & t) const
+	{
+		const int i = TileIndex(t);
+		const int x = i % m_mapWidth - m_left;
+		const int y = i / m_mapWidth - m_top;
+		return ((x < 0) || (x >= m_width) || (y < 0) || (y >= m_height)) ? nullptr : &m_Potentials[y * m_width + x];
+	}
+
+	void				Clear()									{ fill(m_Potentials.begin(), m_Potentials.end(), 0); }
+
+	// Sets the summed-area tables from the current Potentials.
+	// They only cover the window of the bounding box made of the footprints of the locations in [topLeft, bottomRight].
+	// Entry (x, y) is the sum over the Tiles of the rectangle [0, x) x [0, y) of that window.
+	void				ComputeSums(const TilePosition & topLeft, const TilePosition & bottomRight, const TilePosition & dimCC)
+	{
+		const int footprintWidth = static_cast<int>(ceil(dimCC.x));
+		const int footprintHeight = static_cast<int>(ceil(dimCC.y));
+
+		int left = m_width;
+		int top = m_height;
+		int right = -1;
+		int bottom = -1;
+		for (float y = topLeft.y ; y <= bottomRight.y ; ++y)
+		for (float x = topLeft.x ; x <= bottomRight.x ; ++x)
+		{
+			const int i = TileIndex(TilePosition(x, y));
+			left = min(left, i % m_mapWidth - m_left);
+			top = min(top, i / m_mapWidth - m_top);
+			right = max(right, i % m_mapWidth - m_left + footprintWidth - 1);
+			bottom = max(bottom, i / m_mapWidth - m_top + footprintHeight - 1);
+		}
+
+		m_sumsLeft = max(left, 0);
+		m_sumsTop = max(top, 0);
+		m_sumsWidth = max(min(right, m_width - 1) - m_sumsLeft + 1, 0);
+		m_sumsHeight = max(min(bottom, m_height - 1) - m_sumsTop + 1, 0);
+
+		const int w = m_sumsWidth + 1;
+		m_PotentialSums.assign(w * (m_sumsHeight + 1), 0);
+		m_ForbiddenSums.assign(w * (m_sumsHeight + 1), 0);
+		for (int y = 0 ; y < m_sumsHeight ; ++y)
+		{
+			int rowPotential = 0;
+			int rowForbidden = 0;
+			for (int x = 0 ; x < m_sumsWidth ; ++x)
+			{
+				const int j = (m_sumsTop + y) * m_width + m_sumsLeft + x;
+				rowPotential += m_Potentials[j];
+				rowForbidden += (m_Forbidden[j] || (m_Potentials[j] == -1)) ? 1 : 0;
+
+				const int i = (y + 1) * w + x + 1;
+				m_PotentialSums[i] = m_PotentialSums[i - w] + rowPotential;
+				m_ForbiddenSums[i] = m_ForbiddenSums[i - w] + rowForbidden;
+			}
+		}
+	}
+
+	// Calculates the score >= 0 corresponding to the placement of a Base Command Center at 'location'.
+	// The more there are ressources nearby, the higher the score is: it is the sum of the Potentials of the footprint,
+	// made of the Tiles pMap->GetTile(location + (dx, dy)).
+	// Returns -1 if the location is impossible, i.e. if some Tile of the footprint is forbidden (not buildable, not in this Area,
+	// or occupied by some static building) or has the Potential -1 (which means there is some ressource at maximum 3 tiles,
+	// which Starcraft rules forbid. Unfortunately, this is guaranteed only for the ressources in this Area,
+	// which is the very reason of Area::ValidateBaseLocation).
+	// If the footprint is a rectangle of the Map, the summed-area tables give the score in O(1).
+	// Otherwise (i.e. at the right and bottom borders of the Map), the Tiles are just checked one by one.
+	int					Score(const TilePosition & location, const TilePosition & dimCC) const
+	{
+		const int footprintWidth = static_cast<int>(ceil(dimCC.x));
+		const int footprintHeight = static_cast<int>(ceil(dimCC.y));
+
+		const int i = TileIndex(location);
+		if ((i % m_mapWidth + footprintWidth > m_mapWidth) ||
+			(i + (footprintHeight - 1) * m_mapWidth + footprintWidth - 1 >= int(m_pMap->Tiles().size())))
+		{
+			int sumScore = 0;
+			for (int dy = 0 ; dy < footprintHeight ; ++dy)
+			for (int dx = 0 ; dx < footprintWidth ; ++dx)
+			{
+				const int * pPotential = Potential(location + TilePosition(static_cast<float>(dx), static_cast<float>(dy)));
+				if (!pPotential || (*pPotential == -1) || m_Forbidden[pPotential - m_Potentials.data()]) return -1;
+				sumScore += *pPotential;
+			}
+			return sumScore;
+		}
+
+		// Relative to the window of the summed-area tables. As location is one of the locations given to ComputeSums,
+		// the footprint can only exceed the window where the window is clipped by the bounding box.
+		const int x = i % m_mapWidth - m_left - m_sumsLeft;
+		const int y = i / m_mapWidth - m_top - m_sumsTop;
+		if ((x < 0) || (x + footprintWidth > m_sumsWidth) || (y < 0) || (y + footprintHeight > m_sumsHeight))
+			return -1;		// some Tile of the footprint is not in this Area
+
+		const auto sum = [this, x, y, footprintWidth, footprintHeight](const vector<int> & Sums)
+		{
+			const int w = m_sumsWidth + 1;
+			return Sums[(y + footprintHeight) * w + x + footprintWidth] - Sums[y * w + x + footprintWidth]
+				 - Sums[(y + footprintHeight) * w + x] + Sums[y * w + x];
+		};
+
+		return sum(m_ForbiddenSums) ? -1 : sum(m_PotentialSums);
+	}
+
+private:
+	// The index in Map::Tiles() of pMap->GetTile(t), which t may be fractional.
+	int					TileIndex(const TilePosition & t) const	{ return static_cast<int>(&m_pMap->GetTile(t, check_t::no_check) - m_pMap->Tiles().data()); }
+
+	const Map *			m_pMap;
+	int					m_mapWidth;
+	int					m_left;
+	int					m_top;
+	int					m_width;
+	int					m_height;
+	vector<int>			m_Potentials;			// index == y * m_width + x, relative to (m_left, m_top)
+	vector<bool>		m_Forbidden;			// same index
+	int					m_sumsLeft = 0;			// the window of the summed-area tables, relative to (m_left, m_top)
+	int					m_sumsTop = 0;
+	int					m_sumsWidth = 0;
+	int					m_sumsHeight = 0;
+	vector<int>			m_PotentialSums;		// index == y * (m_sumsWidth + 1) + x
+	vector<int>			m_ForbiddenSums;		// same index
+};
+
+} // namespace detail
+
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 //                                                                                          //
 //                                  class Area
@@ -115,56 +274,80 @@ void Area::AddChokePoints(Area * pArea, vector<ChokePoint> * pChokePoints)
 
 
 
+int Area::DistanceToChokePoint(TilePosition t, const ChokePoint * cp) const
+{
+	return ChokePointDistanceField(cp).Distance(TileCoord(t));
+}
+
+
+const DistanceField & Area::ChokePointDistanceField(const ChokePoint * cp) const
+{
+	const auto it = find(m_ChokePoints.begin(), m_ChokePoints.end(), cp);
+	bwem_assert(it != m_ChokePoints.end());
+	bwem_assert(m_ChokePointDistanceFields.size() == m_ChokePoints.size());
+
+	return m_ChokePointDistanceFields[it - m_ChokePoints.begin()];
+}
+
+
+// Returns Distances such that Distances[i] == ground_distance(pStartCP, TargetCPs[i]) in pixels, or 0 if TargetCPs[i] is not reachable.
+// Assumes ComputeChokePointDistanceFields has been called.
 vector<int> Area::ComputeDistances(const ChokePoint * pStartCP, const vector<const ChokePoint *> & TargetCPs) const
 {
 	bwem_assert(!contains(TargetCPs, pStartCP));
 
-	TilePosition start = GetMap()->BreadthFirstSearch(TilePosition(pStartCP->PosInArea(ChokePoint::middle, this)),
-								[this](const Tile & tile, TilePosition) { return tile.AreaId() == Id(); },	// findCond
-								[](const Tile &,          TilePosition) { return true; });					// visitCond
+	const DistanceField & Field = ChokePointDistanceField(pStartCP);
 
-	vector<TilePosition> Targets;
+	vector<int> Distances;
 	for (const ChokePoint * cp : TargetCPs)
-		Targets.push_back(GetMap()->BreadthFirstSearch(TilePosition(cp->PosInArea(ChokePoint::middle, this)),
+		Distances.push_back(max(0, Field.Distance(ChokePointDistanceField(cp).Origin())));
+
+	return Distances;
+}
+
+
+// Computes one DistanceField for each ChokePoint of this Area.
+// Its Origin is the Tile containing the middle of the ChokePoint, or the nearest one inside this Area.
+void Area::ComputeChokePointDistanceFields()
+{
+	m_ChokePointDistanceFields.clear();
+	m_ChokePointDistanceFields.reserve(m_ChokePoints.size());
+
+	for (const ChokePoint * cp : m_ChokePoints)
+	{
+		// Note: TilePosition(PosInArea) is not integral, so the search starts from a TileCoord.
+		const TilePosition origin = GetMap()->BreadthFirstSearch(TilePosition(TileCoord(TilePosition(cp->PosInArea(ChokePoint::middle, this)))),
 								[this](const Tile & tile, TilePosition) { return tile.AreaId() == Id(); },	// findCond
-								[](const Tile &,          TilePosition) { return true; }));					// visitCond
+								[](const Tile &,          TilePosition) { return true; });					// visitCond
 
-	return ComputeDistances(start, Targets);
+		m_ChokePointDistanceFields.push_back(ComputeDistanceField(TileCoord(origin)));
+	}
 }
 
 
-// Returns Distances such that Distances[i] == ground_distance(start, Targets[i]) in pixels
-// Note: same algorithm than Graph::ComputeDistances (derived from Dijkstra)
-vector<int> Area::ComputeDistances(TilePosition start, const vector<TilePosition> & Targets) const
+// Returns the ground distances in pixels from origin to each Tile of this Area (derived from Dijkstra).
+// The search also goes through the Tiles shared with other Areas (AreaId() == -1).
+// Note: same algorithm than Graph::ComputeDistances
+DistanceField Area::ComputeDistanceField(TileCoord origin) const
 {
 	const Map * pMap = GetMap();
-	vector<int> Distances(Targets.size());
 
-	Tile::UnmarkAll();
+	// The nodes of the search are the Tiles, identified by their index in Map::Tiles().
+	const int width = static_cast<int>(pMap->Size().x);
+	const auto index = [width](const TilePosition & t) { return static_cast<int>(t.y) * width + static_cast<int>(t.x); };
 
-	multimap<int, TilePosition> ToVisit;	// a priority queue holding the tiles to visit ordered by their distance to start.
-	ToVisit.emplace(0, start);
+	static thread_local ShortestPathSearch<TilePosition> Search;
+	Search.Begin(width * static_cast<int>(pMap->Size().y));
+	Search.Relax(index(origin), origin, 0);
 
-	int remainingTargets = Targets.size();
-	while (!ToVisit.empty())
+	TileCoord topLeft = origin;
+	TileCoord bottomRight = origin;
+	while (!Search.Empty())
 	{
-		int currentDist = ToVisit.begin()->first;
-		TilePosition current = ToVisit.begin()->second;
-		const Tile & currentTile = pMap->GetTile(current, check_t::no_check);
-		bwem_assert(currentTile.InternalData() == currentDist);
-		ToVisit.erase(ToVisit.begin());
-		currentTile.SetInternalData(0);										// resets Tile::m_internalData for future usage
-		currentTile.SetMarked();
-
-		for (int i = 0; i < (int)Targets.size(); ++i)
-		{
-			if (current == Targets[i])
-			{
-				Distances[i] = int(0.5 + currentDist * 32 / 10000.0);
-				--remainingTargets;
-			}
-		}
-		if (!remainingTargets) break;
+		const int c = Search.Pop();
+		const TilePosition current = Search.Node(c);
+		const int currentDist = Search.Distance(c);
+		makeBoundingBoxIncludePoint(topLeft, bottomRight, TileCoord(current));
 
 		for (TilePosition delta : {	TilePosition(-1, -1), TilePosition(0, -1), TilePosition(+1, -1),
 									TilePosition(-1,  0),                      TilePosition(+1,  0),
@@ -176,44 +359,30 @@ vector<int> Area::ComputeDistances(TilePosition start, const vector<TilePosition
 			TilePosition next = current + delta;
 			if (pMap->Valid(next))
 			{
-				const Tile & nextTile = pMap->GetTile(next, check_t::no_check); 
-				if (!nextTile.Marked())
+				const int n = index(next);
+				if (!Search.Reached(n))		// first time next is reached
 				{
-					if (nextTile.InternalData())	// next already in ToVisit
-					{
-						if (newNextDist < nextTile.InternalData())		// nextNewDist < nextOldDist
-						{	// To update next's distance, we need to remove-insert it from ToVisit:
-							auto range = ToVisit.equal_range(nextTile.InternalData());
-							auto iNext = find_if(range.first, range.second, [next]
-								(const pair<int, TilePosition> & e) { return e.second == next; });
-							bwem_assert(iNext != range.second);
-
-							ToVisit.erase(iNext);
-							nextTile.SetInternalData(newNextDist);
-						//	nextTile.SetPtr(const_cast<Tile *>(&currentTile));		// note: we won't use this backward trace
-							ToVisit.emplace(newNextDist, next);
-						}
-					}
-					else if ((nextTile.AreaId() == Id()) || (nextTile.AreaId() == -1))
-					{
-						nextTile.SetInternalData(newNextDist);
-					//	nextTile.SetPtr(const_cast<Tile *>(&currentTile));			// note: we won't use this backward trace
-						ToVisit.emplace(newNextDist, next);
-					}
+					const Tile & nextTile = pMap->Tiles()[n];
+					if ((nextTile.AreaId() != Id()) && (nextTile.AreaId() != -1)) continue;
 				}
+
+				Search.Relax(n, next, newNextDist, c);	// note: we won't use the backward trace
 			}
 		}
 	}
-	std::cout << "Error " << remainingTargets << " from " << Targets.size() << std::endl;
-//	bwem_assert(!remainingTargets);
 
-	// Reset Tile::m_internalData for future usage
-	for (auto e : ToVisit)
-	{
-		pMap->GetTile(e.second, check_t::no_check).SetInternalData(0);
-	}
-	
-	return Distances;
+	// All the Tiles reached are closed, and they all lie in [topLeft, bottomRight].
+	// The distances that don't fit in 16 bits (Areas wider than about 2048 Tiles) are saturated, rather than wrapped.
+	DistanceField Field(origin, topLeft, bottomRight.x - topLeft.x + 1, bottomRight.y - topLeft.y + 1);
+	for (int16_t y = topLeft.y ; y <= bottomRight.y ; ++y)
+	for (int16_t x = topLeft.x ; x <= bottomRight.x ; ++x)
+		if (Search.Reached(y * width + x))
+		{
+			const int d = int(0.5 + Search.Distance(y * width + x) * 32 / 10000.0);
+			Field.Set(TileCoord(x, y), min(d, int(DistanceField::max_distance)));
+		}
+
+	return Field;
 }
 
 
@@ -258,53 +427,11 @@ void Area::PostCollectInformation()
 
 
 
-// Calculates the score >= 0 corresponding to the placement of a Base Command Center at 'location'.
-// The more there are ressources nearby, the higher the score is.
-// The function assumes the distance to the nearby ressources has already been computed (in InternalData()) for each tile around.
-// The job is therefore made easier : just need to sum the InternalData() values.
-// Returns -1 if the location is impossible.
-
-int Area::ComputeBaseLocationScore(TilePosition location) const
-{
-	const Map * pMap = GetMap();
-	const TilePosition dimCC = GetSizeFromRadius(Sc2UnitTypes::getInstance().GetUnitRadius(UNIT_TYPEID::TERRAN_COMMANDCENTER));
-
-	int sumScore = 0;
-	for (int dy = 0 ; dy < dimCC.y ; ++dy)
-	{
-		for (int dx = 0; dx < dimCC.x; ++dx)
-		{
-			const Tile & tile = pMap->GetTile(location + TilePosition(static_cast<float>(dx), static_cast<float>(dy)), check_t::no_check);
-			if (!tile.Buildable())
-			{
-				return -1;
-			}
-			if (tile.InternalData() == -1)
-			{
-				return -1;		// The special value InternalData() == -1 means there is some ressource at maximum 3 tiles, which Starcraft rules forbid.
-			}
-			// Unfortunately, this is guaranteed only for the ressources in this Area, which is the very reason of ValidateBaseLocation
-			if (tile.AreaId() != Id())
-			{
-				return -1;
-			}
-			if (tile.GetNeutral() && tile.GetNeutral()->IsStaticBuilding())
-			{
-				return -1;
-			}
-			sumScore += tile.InternalData();
-		}
-	}
-
-	return sumScore;
-}
-
-
 // Checks if 'location' is a valid location for the placement of a Base Command Center.
 // If the location is valid except for the presence of Mineral patches of less than 9 (see Andromeda.scx),
 // the function returns true, and these Minerals are reported in BlockingMinerals
-// The function is intended to be called after ComputeBaseLocationScore, as it is more expensive.
-// See also the comments inside ComputeBaseLocationScore.
+// The function is intended to be called after BaseLocationField::Score, as it is more expensive.
+// See also the comments inside BaseLocationField::Score.
 bool Area::ValidateBaseLocation(TilePosition location, vector<Mineral *> & BlockingMinerals) const
 {
 	const Map * pMap = GetMap();
@@ -356,7 +483,7 @@ bool Area::ValidateBaseLocation(TilePosition location, vector<Mineral *> & Block
 // The algorithm repeatedly searches the best possible location L (near ressources)
 // When it finds one, the nearby ressources are assigned to L, which makes the remaining ressources decrease.
 // This causes the algorithm to always terminate due to the lack of remaining ressources.
-// To efficiently compute the distances to the ressources, with use Potiential Fields in the InternalData() value of the Tiles.
+// To efficiently compute the distances to the ressources, with use Potiential Fields in Potential (index == Tile index in Map::Tiles()).
 void Area::CreateBases()
 {
 	const TilePosition dimCC = GetSizeFromRadius(Sc2UnitTypes::getInstance().GetUnitRadius(UNIT_TYPEID::TERRAN_COMMANDCENTER));
@@ -369,6 +496,9 @@ void Area::CreateBases()
 	for (Geyser * g : Geysers())	if ((g->InitialAmount() >= 300) && !g->Blocking()) RemainingRessources.push_back(g);
 
 	m_Bases.reserve(min(100, (int)RemainingRessources.size()));
+	if (RemainingRessources.empty()) return;
+
+	BaseLocationField Field(this);
 
 	while (!RemainingRessources.empty())
 	{
@@ -401,7 +531,7 @@ void Area::CreateBases()
 						int dist = static_cast<int>((distToRectangle(center(t), r->TopLeft(), r->Size()) + 16) / 32);
 						int score = max(max_tiles_between_CommandCenter_and_ressources + 3 - dist, 0);
 						if (r->IsGeyser()) score *= 3;		// somewhat compensates for Geyser alone vs the several Minerals
-						if (tile.AreaId() == Id()) tile.SetInternalData(tile.InternalData() + score);	// note the additive effect (assume tile.InternalData() is 0 at the begining)
+						if (tile.AreaId() == Id()) *Field.Potential(t) += score;	// note the additive effect (assume the Potential of t is 0 at the begining)
 					}
 				}
 			}
@@ -417,7 +547,7 @@ void Area::CreateBases()
 					TilePosition t = r->TopLeft() + TilePosition(dx, dy);
 					if (pMap->Valid(t))
 					{
-						pMap->GetTile(t, check_t::no_check).SetInternalData(-1);
+						if (int * pPotential = Field.Potential(t)) *pPotential = -1;
 					}
 				}
 			}
@@ -425,6 +555,7 @@ void Area::CreateBases()
 
 
 		// 4) Search the best location inside the SearchBoundingBox:
+		Field.ComputeSums(topLeftSearchBoundingBox, bottomRightSearchBoundingBox, dimCC);
 		TilePosition bestLocation;
 		int bestScore = 0;
 		vector<Mineral *> BlockingMinerals;
@@ -433,7 +564,7 @@ void Area::CreateBases()
 		{
 			for (float x = topLeftSearchBoundingBox.x; x <= bottomRightSearchBoundingBox.x; ++x)
 			{
-				int score = ComputeBaseLocationScore(TilePosition(x, y));
+				int score = Field.Score(TilePosition(x, y), dimCC);
 				if (score > bestScore)
 				{
 					if (ValidateBaseLocation(TilePosition(x, y), BlockingMinerals))
@@ -445,21 +576,9 @@ void Area::CreateBases()
 			}
 		}
 
-		// 5) Clear Tile::m_internalData (required due to our use of Potential Fields: see comments in 2))
-		for (const Ressource * r : RemainingRessources)
-		{
-			for (float dy = -dimCC.y - max_tiles_between_CommandCenter_and_ressources; dy < r->Size().y + dimCC.y + max_tiles_between_CommandCenter_and_ressources; ++dy)
-			{
-				for (float dx = -dimCC.x - max_tiles_between_CommandCenter_and_ressources; dx < r->Size().x + dimCC.x + max_tiles_between_CommandCenter_and_ressources; ++dx)
-				{
-					TilePosition t = r->TopLeft() + TilePosition(dx, dy);
-					if (pMap->Valid(t))
-					{
-						pMap->GetTile(t, check_t::no_check).SetInternalData(0);
-					}
-				}
-			}
-		}
+		// 5) Clear the Potentials (required due to our use of Potential Fields: see comments in 2))
+		Field.Clear();
+
 		if (!bestScore) break;
 
 		// 6) Create a new Base at bestLocation, assign to it the relevant ressources and remove them from RemainingRessources:
@@ -13,6 +13,7 @@
 
 #include "Position.h"
 #include "bwapiExt.h"
+#include "distanceField.h"
 #include "utils.h"
 #include "defs.h"
 
@@ -45,10 +46,9 @@ namespace detail { class Graph; }
 // Like ChokePoints and Bases, the number and the addresses of Area instances remain unchanged.
 // To access Areas one can use their ids or their addresses with equivalent efficiency.
 //
-// Areas inherit utils::Markable, which provides marking ability
 // Areas inherit utils::UserData, which provides free-to-use data.
 
-class Area : public utils::Markable<Area, int>, public utils::UserData
+class Area : public utils::UserData
 {
 public:
 	typedef int16_t					id;
@@ -104,6 +104,15 @@ public:
 	// Note: if there are no neighbouring Areas, than an empty set is returned.
 	const std::map<const Area *, const std::vector<ChokePoint> *> &	ChokePointsByArea() const	{ return m_ChokePointsByArea; }
 
+	// Returns the ground distance in pixels from the Tile t to cp (one of ChokePoints()), walking inside this Area,
+	// or -1 if cp cannot be reached that way (for example if t is not in this Area).
+	// This is just a lookup in ChokePointDistanceField(cp).
+	int								DistanceToChokePoint(Sc2Bindings::TilePosition t, const ChokePoint * cp) const;
+
+	// Returns the distances from the Tiles of this Area to cp (one of ChokePoints()).
+	// They are computed once, when the Map is initialized (or when the Areas are updated).
+	const DistanceField &			ChokePointDistanceField(const ChokePoint * cp) const;
+
 	// Returns the accessible neighbouring Areas.
 	// The accessible neighbouring Areas are a subset of the neighbouring Areas (the neighbouring Areas can be iterated using ChokePointsByArea()).
 	// Two neighbouring Areas are accessible from each over if at least one the ChokePoints they share is not Blocked (Cf. ChokePoint::Blocked).
@@ -145,6 +154,8 @@ public:
 	void							OnMineralDestroyed(const Mineral * pMineral);
 	void							PostCollectInformation();
 	std::vector<int>				ComputeDistances(const ChokePoint * pStartCP, const std::vector<const ChokePoint *> & TargetCPs) const;
+	void							ComputeChokePointDistanceFields();
+	std::vector<DistanceField> &	ChokePointDistanceFields()	{ return m_ChokePointDistanceFields; }		// index == index in ChokePoints()
 	void							UpdateAccessibleNeighbours();
 	void							SetGroupId(groupId gid)	{ bwem_assert(gid >= 1); m_groupId = gid; }
 	void							CreateBases();
@@ -154,9 +165,8 @@ private:
 	const detail::Graph *			GetGraph() const		{ return m_pGraph; }
 	detail::Graph *					GetGraph()				{ return m_pGraph; }
 
-	int								ComputeBaseLocationScore(Sc2Bindings::TilePosition location) const;
 	bool							ValidateBaseLocation(Sc2Bindings::TilePosition location, std::vector<Mineral *> & BlockingMinerals) const;
-	std::vector<int>				ComputeDistances(Sc2Bindings::TilePosition start, const std::vector<Sc2Bindings::TilePosition> & Targets) const;
+	DistanceField					ComputeDistanceField(Sc2Bindings::TileCoord origin) const;
 
 	detail::Graph * const			m_pGraph;
 	id								m_id;
@@ -174,6 +184,7 @@ private:
 	std::map<const Area *, const std::vector<ChokePoint> *>	m_ChokePointsByArea;
 	std::vector<const Area *>		m_AccessibleNeighbours;
 	std::vector<const ChokePoint *>	m_ChokePoints;
+	std::vector<DistanceField>		m_ChokePointDistanceFields;		// index == index in m_ChokePoints
 	std::vector<Mineral *>			m_Minerals;
 	std::vector<Geyser *>			m_Geysers;
 	std::vector<Base>				m_Bases;
@@ -0,0 +1,69 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is part of the BWEM Library.
+// BWEM is free software, licensed under the MIT/X11 License.
+// A copy of the license is provided with the library in the LICENSE file.
+// Copyright (c) 2015, 2017, Igor Dimitrijevic
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef BWEM_BIT_GRID_H
+#define BWEM_BIT_GRID_H
+
+#include <vector>
+#include <cstdint>
+#include "defs.h"
+
+
+namespace SC2EM {
+namespace utils {
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class BitGrid
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+//
+// A width x height grid of bits, packed in 64-bit words.
+// Each row starts on a new word, so that rows can be processed a word (64 cells) at a time.
+// Bit x of a row is bit (x % 64) of the word (x / 64). The padding bits of the last word of each row are 0.
+//
+
+class BitGrid
+{
+public:
+	typedef uint64_t word_t;
+	enum { bits_per_word = 64 };
+
+								BitGrid() = default;
+								BitGrid(int width, int height)
+									: m_width(width), m_height(height), m_wordsPerRow((width + bits_per_word - 1) / bits_per_word),
+									m_Words(size_t(m_wordsPerRow) * height, 0) {}
+
+	int							Width() const				{ return m_width; }
+	int							Height() const				{ return m_height; }
+	int							WordsPerRow() const			{ return m_wordsPerRow; }
+
+	const word_t *				Row(int y) const			{ bwem_assert((0 <= y) && (y < m_height)); return &m_Words[size_t(y) * m_wordsPerRow]; }
+	word_t *					Row(int y)					{ bwem_assert((0 <= y) && (y < m_height)); return &m_Words[size_t(y) * m_wordsPerRow]; }
+
+	bool						Get(int x, int y) const		{ bwem_assert((0 <= x) && (x < m_width)); return ((Row(y)[x / bits_per_word] >> (x % bits_per_word)) & 1) != 0; }
+	void						Set(int x, int y)			{ bwem_assert((0 <= x) && (x < m_width)); Row(y)[x / bits_per_word] |= word_t(1) << (x % bits_per_word); }
+
+	// Returns the mask of the padding bits of the last word of each row.
+	word_t						PaddingMask() const			{ return (m_width % bits_per_word) ? ~word_t(0) << (m_width % bits_per_word) : 0; }
+
+private:
+	int							m_width = 0;
+	int							m_height = 0;
+	int							m_wordsPerRow = 0;
+	std::vector<word_t>			m_Words;
+};
+
+
+}} // namespace SC2EM::utils
+
+
+#endif
@@ -92,7 +92,7 @@ template<typename T, int Scale = 1>
 inline int squaredDist(Sc2Bindings::Point<T, Scale> A, Sc2Bindings::Point<T, Scale> B)	
 { 
 	A -= B; 
-	return squaredNorm(A.x, A.y); 
+	return utils::squaredNorm(A.x, A.y); 
 }
 
 template<typename T, int Scale = 1>
@@ -13,15 +13,20 @@
 
 
 #include "map.h"
+#include "mapSource.h"
+#include "mapStats.h"
 #include "tiles.h"
 #include "area.h"
 #include "cp.h"
+#include "cpPath.h"
+#include "tilePath.h"
 #include "base.h"
 #include "neutral.h"
 #include "gridMap.h"
 #include "examples.h"
 #include "mapPrinter.h"
 #include "mapDrawer.h"
+#include "shortestPaths.h"
 #include "utils.h"
 #include "bwapiExt.h"
 #include "defs.h"
@@ -37,8 +42,11 @@ To get into the documentation of the API, just read the comments in the followin
 	map.h
 	area.h
 	cp.h
+	cpPath.h
+	tilePath.h
 	base.h
 	neutral.h
+	shortestPaths.h (Dijkstra's algorithm, for your own searches over the Tiles or any other graph)
 
 
 Many of the algorithms used in the analysis are parametrised and thus can be easily modified:
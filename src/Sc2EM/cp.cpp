@@ -33,7 +33,7 @@ using namespace sc2_ext;
 //////////////////////////////////////////////////////////////////////////////////////////////
 
 
-ChokePoint::ChokePoint(detail::Graph * pGraph, index idx, const Area * area1, const Area * area2, const deque<WalkPosition> & Geometry, Neutral * pBlockingNeutral)
+ChokePoint::ChokePoint(detail::Graph * pGraph, index idx, const Area * area1, const Area * area2, const deque<WalkCoord> & Geometry, Neutral * pBlockingNeutral)
 : m_pGraph(pGraph), m_index(idx), m_Areas(area1, area2), m_Geometry(Geometry),
 	m_pBlockingNeutral(pBlockingNeutral), m_blocked(pBlockingNeutral != nullptr), m_pseudo(pBlockingNeutral != nullptr)
 {
@@ -64,6 +64,21 @@ ChokePoint::ChokePoint(detail::Graph * pGraph, index idx, const Area * area1, co
 }
 
 
+ChokePoint::ChokePoint(detail::Graph * pGraph, index idx, const Area * area1, const Area * area2, const deque<WalkCoord> & Geometry, Neutral * pBlockingNeutral,
+						const WalkPosition (&nodes)[node_count], const pair<WalkPosition, WalkPosition> (&nodesInArea)[node_count])
+: m_pGraph(pGraph), m_index(idx), m_Areas(area1, area2), m_Geometry(Geometry),
+	m_pBlockingNeutral(pBlockingNeutral), m_blocked(pBlockingNeutral != nullptr), m_pseudo(pBlockingNeutral != nullptr)
+{
+	bwem_assert(!Geometry.empty());
+
+	for (int n = 0 ; n < node_count ; ++n)
+	{
+		m_nodes[n] = nodes[n];
+		m_nodesInArea[n] = nodesInArea[n];
+	}
+}
+
+
 ChokePoint::ChokePoint(const ChokePoint & Other)
 	: m_pGraph(Other.m_pGraph), m_index(0), m_pseudo(false)
 {
@@ -90,7 +105,7 @@ int ChokePoint::DistanceFrom(const ChokePoint * cp) const
 }
 
 
-const CPPath & ChokePoint::GetPathTo(const ChokePoint * cp) const
+CPPath ChokePoint::GetPathTo(const ChokePoint * cp) const
 {
 	return GetGraph()->GetPath(this, cp);
 }
@@ -12,6 +12,7 @@
 #define BWEM_CP_H
 
 #include "bwapiExt.h"
+#include "cpPath.h"
 #include <deque>
 #include "utils.h"
 #include "defs.h"
@@ -51,10 +52,9 @@ namespace detail { class Graph; }
 // for each blocking Neutral (only one in the case of stacked blocking Neutral).
 // Such ChokePoints are called pseudo ChokePoints and they behave differently in several ways.
 //
-// ChokePoints inherit utils::Markable, which provides marking ability
 // ChokePoints inherit utils::UserData, which provides free-to-use data.
 
-class ChokePoint : public utils::Markable<ChokePoint, int>, public utils::UserData
+class ChokePoint : public utils::UserData
 {
 public:
 	// ChokePoint::middle denotes the "middle" MiniTile of Geometry(), while
@@ -64,7 +64,8 @@ public:
 
 	// Type of all the Paths used in BWEM (Cf. Map::GetPath).
 	// See also the typedef CPPath.
-	typedef std::vector<const ChokePoint *> Path;
+	// Paths are lightweight views, which can be iterated like a std::vector<const ChokePoint *> (Cf. CPPathView).
+	typedef CPPathView Path;
 
 	// Tells whether this ChokePoint is a pseudo ChokePoint, i.e., it was created on top of a blocking Neutral.
 	bool									IsPseudo() const		{ return m_pseudo; }
@@ -88,7 +89,8 @@ public:
 	//       They are however guaranteed to be part of one of the 2 Areas.
 	// Note: the returned set contains Pos(middle), Pos(end1) and Pos(end2).
 	// If IsPseudo(), returns {p} where p is the position of a walkable MiniTile near from BlockingNeutral()->Pos().
-	const std::deque<Sc2Bindings::WalkPosition> &	Geometry() const		{ return m_Geometry; }
+	// Note: the positions are WalkCoords, no longer WalkPositions (Cf. Map::RawFrontier).
+	const std::deque<Sc2Bindings::WalkCoord> &	Geometry() const		{ return m_Geometry; }
 
 	// If !IsPseudo(), returns false.
 	// Otherwise, returns whether this ChokePoint is considered blocked.
@@ -124,13 +126,13 @@ public:
 	// The path always starts with this ChokePoint and ends with cp, unless AccessibleFrom(cp) == false.
 	// In this case, an empty list is returned.
 	// Note: if this == cp, returns [cp].
-	// Time complexity: O(1)
+	// Time complexity: O(size) (Cf. CPPathView: then size() is O(1), iterating the path is O(size) and operator[](i) is O(i))
 	// To get the length of the path returned in pixels, use DistanceFrom(cp).
 	// Note: all the possible Paths are precomputed during Map::Initialize().
 	//       The best one is then stored for each pair of ChokePoints.
 	//       However, only the center of the ChokePoints is considered.
 	//       As a consequence, the returned path may not be the shortest one.
-	const ChokePoint::Path &				GetPathTo(const ChokePoint * cp) const;
+	ChokePoint::Path						GetPathTo(const ChokePoint * cp) const;
 
 	Map *									GetMap() const;
 
@@ -140,12 +142,13 @@ public:
 //	Details: The functions below are used by the BWEM's internals
 
 	typedef int								index;
-											ChokePoint(detail::Graph * pGraph, index idx, const Area * area1, const Area * area2, const std::deque<Sc2Bindings::WalkPosition> & Geometry, Neutral * pBlockingNeutral = nullptr);
+											ChokePoint(detail::Graph * pGraph, index idx, const Area * area1, const Area * area2, const std::deque<Sc2Bindings::WalkCoord> & Geometry, Neutral * pBlockingNeutral = nullptr);
+											// Restores a ChokePoint saved in the analysis cache (the nodes are not recomputed).
+											ChokePoint(detail::Graph * pGraph, index idx, const Area * area1, const Area * area2, const std::deque<Sc2Bindings::WalkCoord> & Geometry, Neutral * pBlockingNeutral,
+													const Sc2Bindings::WalkPosition (&nodes)[node_count], const std::pair<Sc2Bindings::WalkPosition, Sc2Bindings::WalkPosition> (&nodesInArea)[node_count]);
 											ChokePoint(const ChokePoint & Other);
 	void									OnBlockingNeutralDestroyed(const Neutral * pBlocking);
 	index									Index() const			{ return m_index; }
-	const ChokePoint *						PathBackTrace() const							{ return m_pPathBackTrace; }
-	void									SetPathBackTrace(const ChokePoint * p) const	{ m_pPathBackTrace = p; }
 
 private:
 	const detail::Graph *					GetGraph() const		{ return m_pGraph; }
@@ -157,10 +160,9 @@ private:
 	const std::pair<const Area *, const Area *>			m_Areas;
 	Sc2Bindings::WalkPosition									m_nodes[node_count];
 	std::pair<Sc2Bindings::WalkPosition, Sc2Bindings::WalkPosition>	m_nodesInArea[node_count];
-	const std::deque<Sc2Bindings::WalkPosition>				m_Geometry;
+	const std::deque<Sc2Bindings::WalkCoord>				m_Geometry;
 	bool												m_blocked;
 	Neutral *											m_pBlockingNeutral;
-	mutable const ChokePoint *							m_pPathBackTrace = nullptr;
 };
 
 
@@ -0,0 +1,122 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is part of the BWEM Library.
+// BWEM is free software, licensed under the MIT/X11 License.
+// A copy of the license is provided with the library in the LICENSE file.
+// Copyright (c) 2015, 2017, Igor Dimitrijevic
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef BWEM_CP_PATH_H
+#define BWEM_CP_PATH_H
+
+#include <vector>
+#include <cstdint>
+#include <iterator>
+#include "defs.h"
+
+
+namespace SC2EM {
+
+class ChokePoint;
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class CPPathView
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+//
+// A path of ChokePoints, as returned by Map::GetPath and ChokePoint::GetPathTo (Cf. the typedef CPPath).
+// The paths are not stored: the Graph only stores, for each pair of ChokePoints (a, b), the ChokePoint that follows a
+// on the path from a to b (its next hop). A CPPathView just follows the next hops from its first ChokePoint to its last one.
+// So a CPPathView is a small value that can be copied freely, and iterating it is O(size()).
+// size() is O(1), as the number of ChokePoints is counted once, when the view is made.
+// Unlike a vector, a CPPathView has no random access: operator[](i) follows i next hops, so it is O(i).
+// To index a path in a loop, iterate it or copy it once with ToVector().
+// A CPPathView remains valid as long as the paths are not updated (Cf. Map::EnableAutomaticPathAnalysis).
+// A default-constructed CPPathView is empty.
+//
+
+class CPPathView
+{
+public:
+	// Index of the next hop of a ChokePoint, or none if there is no path.
+	typedef int16_t hop;
+	enum : hop { none = -1 };
+
+	class const_iterator
+	{
+	public:
+		typedef std::forward_iterator_tag	iterator_category;
+		typedef const ChokePoint *			value_type;
+		typedef std::ptrdiff_t				difference_type;
+		typedef const ChokePoint * const *	pointer;
+		typedef const ChokePoint *			reference;
+
+											const_iterator() = default;
+
+		const ChokePoint *					operator*() const		{ bwem_assert(m_current != none); return m_pChokePoints[m_current]; }
+		const_iterator &					operator++()			{ bwem_assert(m_current != none); m_current = (m_current == m_to) ? int(none) : m_pNextHops[m_current * m_count]; return *this; }
+		const_iterator						operator++(int)			{ const_iterator it = *this; ++*this; return it; }
+		bool								operator==(const const_iterator & Other) const { return m_current == Other.m_current; }
+		bool								operator!=(const const_iterator & Other) const { return m_current != Other.m_current; }
+
+	private:
+		friend class CPPathView;
+											const_iterator(const CPPathView & View, int current)
+												: m_pChokePoints(View.m_pChokePoints), m_pNextHops(View.m_pNextHops ? View.m_pNextHops + View.m_to : nullptr), m_count(View.m_count), m_to(View.m_to), m_current(current) {}
+
+		const ChokePoint * const *			m_pChokePoints = nullptr;
+		const hop *							m_pNextHops = nullptr;		// the next hops towards m_to (stride == m_count)
+		int									m_count = 0;
+		int									m_to = none;
+		int									m_current = none;
+	};
+
+										CPPathView() = default;
+
+	// pChokePoints: the ChokePoints, by index (Cf. ChokePoint::Index()).
+	// pNextHops: the count x count next hops, row-major (index == from * count + to).
+										CPPathView(const ChokePoint * const * pChokePoints, const hop * pNextHops, int count, int from, int to)
+											: m_pChokePoints(pChokePoints), m_pNextHops(pNextHops), m_count(count),
+											m_from(((from == to) || (pNextHops[from * count + to] != none)) ? from : int(none)), m_to(to)
+										{
+											if (m_from != none)
+												for (int cp = m_from ; ; cp = m_pNextHops[cp * m_count + m_to])
+												{
+													++m_size;
+													if (cp == m_to) break;
+												}
+										}
+
+	bool								empty() const				{ return m_from == none; }
+	int									size() const				{ return m_size; }
+
+	const_iterator						begin() const				{ return const_iterator(*this, m_from); }
+	const_iterator						end() const					{ return const_iterator(*this, none); }
+
+	const ChokePoint *					front() const				{ bwem_assert(!empty()); return m_pChokePoints[m_from]; }
+	const ChokePoint *					back() const				{ bwem_assert(!empty()); return m_pChokePoints[m_to]; }
+
+	// O(i)
+	const ChokePoint *					operator[](int i) const		{ auto it = begin(); while (i--) ++it; return *it; }
+
+	// Copies the path into a vector (the former representation of CPPath).
+	std::vector<const ChokePoint *>		ToVector() const			{ return std::vector<const ChokePoint *>(begin(), end()); }
+
+private:
+	const ChokePoint * const *			m_pChokePoints = nullptr;
+	const hop *							m_pNextHops = nullptr;
+	int									m_count = 0;
+	int									m_from = none;
+	int									m_to = none;
+	int									m_size = 0;
+};
+
+
+} // namespace SC2EM
+
+
+#endif
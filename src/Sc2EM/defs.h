@@ -37,6 +37,9 @@ namespace detail
 #define BWEM_USE_MAP_PRINTER 1	// enable(1) or disable(0) the compilation of mapPrinter.cpp
 								// mapPrinter.h provides optional utils that require the EasyBMP Library (windows).
 
+#define BWEM_COUNT_ALLOCATIONS 0	// enable(1) or disable(0) the counting of the allocations in Map::GetInitializationStats.
+									// This replaces the global operator new / operator delete of the whole program (see mapStats.cpp).
+
 
 class Exception : public std::runtime_error
 {
@@ -79,6 +82,10 @@ const int min_tiles_between_Bases = 10;
 
 const int max_tiles_between_StartingLocation_and_its_AssignedBase = 3;
 
+// These constants control the landmarks used by Map::GetGroundDistance (Cf. Graph::ComputeLandmarks).
+const int max_landmarks = 8;
+const int max_active_landmarks = 4;		// number of landmarks used by each query (the ones giving the best bounds)
+
 } // namespace detail
 
 
@@ -0,0 +1,88 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is part of the BWEM Library.
+// BWEM is free software, licensed under the MIT/X11 License.
+// A copy of the license is provided with the library in the LICENSE file.
+// Copyright (c) 2015, 2017, Igor Dimitrijevic
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef BWEM_DISTANCE_FIELD_H
+#define BWEM_DISTANCE_FIELD_H
+
+#include "Position.h"
+#include <vector>
+#include <cstdint>
+#include "defs.h"
+
+
+namespace SC2EM {
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class DistanceField
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Ground distances (in pixels) from each Tile of a rectangle to some Origin Tile.
+// Each distance is stored in 16 bits, unreached Tiles holding the value unreached.
+// So the distances are limited to max_distance pixels (about 2048 Tiles): the callers of Set must saturate the longer ones.
+// DistanceFields are computed by the Areas, one for each of their ChokePoints (Cf. Area::ChokePointDistanceField).
+//
+
+class DistanceField
+{
+public:
+	enum : uint16_t { unreached = 0xFFFF, max_distance = unreached - 1 };
+
+									DistanceField() = default;
+									DistanceField(Sc2Bindings::TileCoord origin, Sc2Bindings::TileCoord topLeft, int width, int height)
+										: m_origin(origin), m_topLeft(topLeft), m_width(width), m_height(height), m_Distances(size_t(width) * height, unreached) {}
+
+	// The Tile the distances are measured from.
+	Sc2Bindings::TileCoord			Origin() const				{ return m_origin; }
+
+	// The rectangle covered by this DistanceField. The Tiles outside it are unreached.
+	Sc2Bindings::TileCoord			TopLeft() const				{ return m_topLeft; }
+	int								Width() const				{ return m_width; }
+	int								Height() const				{ return m_height; }
+
+	// Returns the ground distance in pixels from t to Origin(), or -1 if t is unreached.
+	int								Distance(Sc2Bindings::TileCoord t) const
+	{
+		const int x = t.x - m_topLeft.x;
+		const int y = t.y - m_topLeft.y;
+		if ((x < 0) || (x >= m_width) || (y < 0) || (y >= m_height)) return -1;
+
+		const uint16_t d = m_Distances[y * m_width + x];
+		return (d == unreached) ? -1 : d;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	//	Details: The functions below are used by the BWEM's internals
+
+	// Raw distances, row by row (index == y * Width() + x, relative to TopLeft()).
+	const std::vector<uint16_t> &	Raw() const					{ return m_Distances; }
+	std::vector<uint16_t> &			Raw()						{ return m_Distances; }
+
+	void							Set(Sc2Bindings::TileCoord t, int d)
+	{
+		bwem_assert((0 <= d) && (d <= max_distance));
+		m_Distances[(t.y - m_topLeft.y) * m_width + (t.x - m_topLeft.x)] = uint16_t(d);
+	}
+
+private:
+	Sc2Bindings::TileCoord			m_origin = {0, 0};
+	Sc2Bindings::TileCoord			m_topLeft = {0, 0};
+	int								m_width = 0;
+	int								m_height = 0;
+	std::vector<uint16_t>			m_Distances;
+};
+
+
+} // namespace SC2EM
+
+
+#endif
@@ -37,6 +37,17 @@ static bool canBuildWall(const Map & theMap, sc2::UnitTypeID type, TilePosition
 	if (!theMap.Valid(location)) return false;
 	if (!theMap.Valid(location + dim - 1)) return false;
 
+	// The Tiles to check are theMap.GetTile(location + TilePosition(dx, dy)). As location may not be integral,
+	// the footprint starts at the Tile actually returned by GetTile. Unless it crosses the right or bottom border of the Map,
+	// it is then a rectangle, which theMap.CanBuild checks in O(1).
+	const int width = static_cast<int>(theMap.Size().x);
+	const int height = static_cast<int>(theMap.Size().y);
+	const int i = static_cast<int>(&theMap.GetTile(location) - theMap.Tiles().data());
+	const TileCoord topLeft(int16_t(i % width), int16_t(i / width));
+	const TileCoord size(int16_t(ceil(dim.x)), int16_t(ceil(dim.y)));
+	if ((topLeft.x + size.x <= width) && (topLeft.y + size.y <= height))
+		return theMap.CanBuild(topLeft, size);
+
 	for (float dy = 0 ; dy < dim.y ; ++dy)
 	{
 		for (float dx = 0; dx < dim.x; ++dx)
@@ -370,7 +370,7 @@ void pathExample(const Map & theMap)
 	MapPrinter::Get().Circle(b, 6, col, MapPrinter::fill);
 
 	int length;
-	const CPPath & Path = theMap.GetPath(Position(a), Position(b), &length);
+	const CPPath Path = theMap.GetPath(Position(a), Position(b), &length);
 
 	if (length < 0) return;		// cannot reach b from a
 
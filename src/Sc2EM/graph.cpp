@@ -11,8 +11,10 @@
 #include "graph.h"
 #include "mapImpl.h"
 #include "neutral.h"
+#include "mapCache.h"
 #include "winutils.h"
 #include <map>
+#include <unordered_map>
 #include <deque>
 
 
@@ -110,7 +112,10 @@ void Graph::CreateChokePoints()
 		m_ChokePointsMatrix[id].resize(id);			// triangular matrix
 
 	// 2) Dispatch the global raw frontier between all the relevant pairs of Areas:
-	map<pair<Area::id, Area::id>, vector<WalkPosition>> RawFrontierByAreaPair;
+	//    The stable sort by pair of Areas keeps the order of RawFrontier inside each pair (Cf. 3).
+	const int pairKeyBase = AreasCount() + 1;
+	vector<pair<int, WalkCoord>> RawFrontierByAreaPair;		// (a * pairKeyBase + b, w)
+	RawFrontierByAreaPair.reserve(GetMap()->RawFrontier().size());
 	for (const auto & raw : GetMap()->RawFrontier())
 	{
 		Area::id a = raw.first.first;
@@ -119,51 +124,80 @@ void Graph::CreateChokePoints()
 		bwem_assert(a <= b);
 		bwem_assert((a >= 1) && (b <= AreasCount()));
 
-		RawFrontierByAreaPair[make_pair(a, b)].push_back(raw.second);
+		RawFrontierByAreaPair.emplace_back(a * pairKeyBase + b, raw.second);
 	}
+	stable_sort(RawFrontierByAreaPair.begin(), RawFrontierByAreaPair.end(),
+		[](const pair<int, WalkCoord> & p1, const pair<int, WalkCoord> & p2) { return p1.first < p2.first; });
+
+	// The ends of the clusters are indexed by square cells of cluster_min_dist MiniTiles,
+	// so that the ends within cluster_min_dist of some MiniTile can only be in the 3 x 3 cells around it.
+	const int cluster_min_dist = (int)sqrt(lake_max_miniTiles);
+	const auto cellOf = [](int cx, int cy) { return uint32_t(cy) << 16 | uint32_t(cx); };
+	const auto cellOfEnd = [cluster_min_dist, &cellOf](WalkCoord w) { return cellOf(w.x / cluster_min_dist, w.y / cluster_min_dist); };
+
+	vector<deque<WalkCoord>> Clusters;
+	unordered_multimap<uint32_t, int> ClusterEnds;		// cell -> index in Clusters of each cluster having an end (front or back) in cell
+	const auto moveClusterEnd = [&ClusterEnds, &cellOfEnd](int k, WalkCoord from, WalkCoord to)
+	{
+		if (cellOfEnd(from) == cellOfEnd(to)) return;
+
+		const auto Range = ClusterEnds.equal_range(cellOfEnd(from));
+		ClusterEnds.erase(find_if(Range.first, Range.second, [k](const pair<const uint32_t, int> & e) { return e.second == k; }));
+		ClusterEnds.emplace(cellOfEnd(to), k);
+	};
 
 	// 3) For each pair of Areas (A, B):
-	for (auto & raw : RawFrontierByAreaPair)
+	for (size_t first = 0, last ; first < RawFrontierByAreaPair.size() ; first = last)
 	{
-		Area::id a = raw.first.first;
-		Area::id b = raw.first.second;
+		const int pairKey = RawFrontierByAreaPair[first].first;
+		for (last = first + 1 ; (last < RawFrontierByAreaPair.size()) && (RawFrontierByAreaPair[last].first == pairKey) ; ++last) {}
 
-		const vector<WalkPosition> & RawFrontierAB = raw.second;
+		Area::id a = Area::id(pairKey / pairKeyBase);
+		Area::id b = Area::id(pairKey % pairKeyBase);
 
 		// Because our dispatching preserved order,
 		// and because Map::m_RawFrontier was populated in descending order of the altitude (see Map::ComputeAreas),
 		// we know that RawFrontierAB is also ordered the same way, but let's check it:
-		{
-			vector<altitude_t> Altitudes;
-			for (auto w : RawFrontierAB)
-				Altitudes.push_back(GetMap()->GetMiniTile(w).Altitude());
-
-			bwem_assert(is_sorted(Altitudes.rbegin(), Altitudes.rend()));
-		}
+		for (size_t i = first + 1 ; i < last ; ++i)
+			bwem_assert(GetMap()->GetMiniTile(RawFrontierByAreaPair[i-1].second).Altitude() >= GetMap()->GetMiniTile(RawFrontierByAreaPair[i].second).Altitude());
 
 		// 3.1) Use that information to efficiently cluster RawFrontierAB in one or several chokepoints.
 		//    Each cluster will be populated starting with the center of a chokepoint (max altitude)
 		//    and finishing with the ends (min altitude).
-		const int cluster_min_dist = (int)sqrt(lake_max_miniTiles);
-		vector<deque<WalkPosition>> Clusters;
-		for (auto w : RawFrontierAB)
+		//    Each MiniTile joins the first cluster created having an end within cluster_min_dist, if any.
+		Clusters.clear();
+		ClusterEnds.clear();
+		for (size_t i = first ; i < last ; ++i)
 		{
-			bool added = false;
-			for (auto & Cluster : Clusters)
-			{
-				int distToFront = queenWiseDist(Cluster.front(), w);
-				int distToBack = queenWiseDist(Cluster.back(), w);
-				if (min(distToFront, distToBack) <= cluster_min_dist)
+			const WalkCoord w = RawFrontierByAreaPair[i].second;
+			const int cx = w.x / cluster_min_dist;
+			const int cy = w.y / cluster_min_dist;
+
+			int k = -1;		// the first cluster created that w can join
+			for (int dy = -1 ; dy <= +1 ; ++dy)
+			for (int dx = -1 ; dx <= +1 ; ++dx)
+				if ((cx + dx >= 0) && (cy + dy >= 0))
 				{
-					if (distToFront < distToBack)	Cluster.push_front(w);
-					else							Cluster.push_back(w);
-
-					added = true;
-					break;
+					const auto Range = ClusterEnds.equal_range(cellOf(cx + dx, cy + dy));
+					for (auto it = Range.first ; it != Range.second ; ++it)
+						if (((k == -1) || (it->second < k)) &&
+							(min(queenWiseDist(Clusters[it->second].front(), w), queenWiseDist(Clusters[it->second].back(), w)) <= cluster_min_dist))
+							k = it->second;
 				}
+
+			if (k == -1)
+			{
+				Clusters.push_back(deque<WalkCoord>(1, w));
+				ClusterEnds.emplace(cellOfEnd(w), int(Clusters.size()) - 1);		// front
+				ClusterEnds.emplace(cellOfEnd(w), int(Clusters.size()) - 1);		// back
+				continue;
 			}
 
-			if (!added) Clusters.push_back(deque<WalkPosition>(1, w));
+			deque<WalkCoord> & Cluster = Clusters[k];
+			int distToFront = queenWiseDist(Cluster.front(), w);
+			int distToBack = queenWiseDist(Cluster.back(), w);
+			if (distToFront < distToBack)	{ moveClusterEnd(k, Cluster.front(), w); Cluster.push_front(w); }
+			else							{ moveClusterEnd(k, Cluster.back(), w); Cluster.push_back(w); }
 		}
 
 		// 3.2) Create one Chokepoint for each cluster:
@@ -184,16 +218,23 @@ void Graph::CreateChokePoints()
 			{
 				if (pB == pA) break;	// breaks symmetry
 
-				auto center = GetMap()->BreadthFirstSearch(WalkPosition(pNeutral->Pos()),
+				// The search starts from the MiniTile containing the Neutral's position, so that center is a MiniTile too.
+				auto center = GetMap()->BreadthFirstSearch(WalkPosition(WalkCoord(WalkPosition(pNeutral->Pos()))),
 						[](const MiniTile & miniTile, WalkPosition) { return miniTile.Walkable(); },	// findCond
 						[](const MiniTile &,          WalkPosition) { return true; });					// visitCond
 
 				GetChokePoints(pA, pB).reserve(pseudoChokePointsToCreate);
-				GetChokePoints(pA, pB).emplace_back(this, newIndex++, pA, pB, deque<WalkPosition>(1, center), pNeutral);
+				GetChokePoints(pA, pB).emplace_back(this, newIndex++, pA, pB, deque<WalkCoord>(1, WalkCoord(center)), pNeutral);
 			}
 		}
 
 	// 5) Set the references to the freshly created Chokepoints:
+	RegisterChokePoints();
+}
+
+
+void Graph::RegisterChokePoints()
+{
 	for (Area::id a = 1 ; a <= AreasCount() ; ++a)
 	for (Area::id b = 1 ; b < a ; ++b)
 		if (!GetChokePoints(a, b).empty())
@@ -204,108 +245,116 @@ void Graph::CreateChokePoints()
 			for (auto & cp : GetChokePoints(a, b))
 				m_ChokePointList.push_back(&cp);
 		}
+
+	m_ChokePointsByIndex.assign(m_ChokePointList.size(), nullptr);
+	for (const ChokePoint * cp : m_ChokePointList)
+		m_ChokePointsByIndex[cp->Index()] = cp;
 }
 
 
 void Graph::SetDistance(const ChokePoint * cpA, const ChokePoint * cpB, int value)
 {
-	m_ChokePointDistanceMatrix[cpA->Index()][cpB->Index()] =
-	m_ChokePointDistanceMatrix[cpB->Index()][cpA->Index()] = value;
+	m_ChokePointDistanceMatrix[MatrixIndex(cpA, cpB)] =
+	m_ChokePointDistanceMatrix[MatrixIndex(cpB, cpA)] = value;
 }
 
 
-void Graph::SetPath(const ChokePoint * cpA, const ChokePoint * cpB, const CPPath & PathAB)
+// Sets the path from cpA to cpB, given the ChokePoint following cpA and the one preceding cpB on it.
+// Sets the reverse path from cpB to cpA as well.
+void Graph::SetPath(const ChokePoint * cpA, const ChokePoint * cpB, const ChokePoint * afterA, const ChokePoint * beforeB)
 {
-	m_PathsBetweenChokePoints[cpA->Index()][cpB->Index()] = PathAB;
-	m_PathsBetweenChokePoints[cpB->Index()][cpA->Index()].assign(PathAB.rbegin(), PathAB.rend());
+	m_ChokePointNextHops[MatrixIndex(cpA, cpB)] = CPPathView::hop(afterA->Index());
+	m_ChokePointNextHops[MatrixIndex(cpB, cpA)] = CPPathView::hop(beforeB->Index());
 }
 
 
 // Computes the ground distances between any pair of ChokePoints in pContext
-// This is achieved by invoking several times pContext->ComputeDistances,
+// This is achieved by invoking several times ComputeDistances(pContext, ...),
 // which effectively computes the distances from one starting ChokePoint, using Dijkstra's algorithm.
 // If Context == Area, Dijkstra's algorithm works on the Tiles inside one Area.
 // If Context == Graph, Dijkstra's algorithm works on the GetChokePoints between the AreaS.
 template<class Context>
 void Graph::ComputeChokePointDistances(const Context * pContext)
 {
-///	multimap<int, vector<WalkPosition>> trace;
-
 	for (const ChokePoint * pStart : pContext->ChokePoints())
-	{
-		vector<const ChokePoint *> Targets;
-		for (const ChokePoint * cp : pContext->ChokePoints())
-		{
-			if (cp == pStart) break;	// breaks symmetry
-			Targets.push_back(cp);
-		}
+		SetDistancesFrom(ComputeDistancesFrom(pContext, pStart));
+}
 
-		auto DistanceToTargets = pContext->ComputeDistances(pStart, Targets);
+template void Graph::ComputeChokePointDistances<Graph>(const Graph * pContext);
 
-		for (int i = 0 ; i < (int)Targets.size() ; ++i)
-		{
-			int newDist = DistanceToTargets[i];
-			int existingDist = Distance(pStart, Targets[i]);
 
-			if (newDist && ((existingDist == -1) || (newDist < existingDist)))
-			{
-				SetDistance(pStart, Targets[i], newDist);
+// Computes the distances from pStart to the ChokePoints preceding it in pContext->ChokePoints() (this breaks symmetry).
+// Only reads the matrix, so that the Areas can be processed concurrently (Cf. ComputeChokePointDistanceMatrix).
+template<class Context>
+Graph::DistancesFrom Graph::ComputeDistancesFrom(const Context * pContext, const ChokePoint * pStart) const
+{
+	DistancesFrom Result;
+	Result.pStart = pStart;
+	for (const ChokePoint * cp : pContext->ChokePoints())
+	{
+		if (cp == pStart) break;	// breaks symmetry
+		Result.Targets.push_back(cp);
+	}
+
+	Result.Distances = ComputeDistances(pContext, pStart, Result.Targets, Result.FirstHops, Result.LastHops);
+	return Result;
+}
 
-				// Build the path from pStart to Targets[i]:
 
-				CPPath Path {pStart, Targets[i]};
+// Keeps the new distances that are shorter than the ones already known.
+void Graph::SetDistancesFrom(const DistancesFrom & Result)
+{
+///	multimap<int, vector<WalkPosition>> trace;
 
-				// if (Context == Graph), there may be intermediate ChokePoints. They have been set by ComputeDistances,
-				// so we just have to collect them (in the reverse order) and insert them into Path:
-				if ((void *)(pContext) == (void *)(this))	// tests (Context == Graph) without warning about constant condition
-					for (const ChokePoint * pPrev = Targets[i]->PathBackTrace() ; pPrev != pStart ; pPrev = pPrev->PathBackTrace())
-						Path.insert(Path.begin()+1, pPrev);
+	for (int i = 0 ; i < (int)Result.Targets.size() ; ++i)
+	{
+		int newDist = Result.Distances[i];
+		int existingDist = Distance(Result.pStart, Result.Targets[i]);
 
-				SetPath(pStart, Targets[i], Path);
+		if (newDist && ((existingDist == -1) || (newDist < existingDist)))
+		{
+			SetDistance(Result.pStart, Result.Targets[i], newDist);
+			SetPath(Result.pStart, Result.Targets[i], Result.FirstHops[i], Result.LastHops[i]);
 
-			///	vector<WalkPosition> PathTrace;
-			///	for (auto e : Path) PathTrace.push_back(e->Center());
-			///	trace.emplace(int(0.5 + DistanceToTargets[i]/8.0), PathTrace);
-			}
+		///	vector<WalkPosition> PathTrace;
+		///	for (auto e : GetPath(Result.pStart, Result.Targets[i])) PathTrace.push_back(e->Center());
+		///	trace.emplace(int(0.5 + Result.Distances[i]/8.0), PathTrace);
 		}
 	}
 
 ///	for (auto & line : trace) { Log << line.first; for (auto e : line.second) Log << " " << e; Log << endl; }
-
 }
 
-template void Graph::ComputeChokePointDistances<Graph>(const Graph * pContext);
-template void Graph::ComputeChokePointDistances<Area>(const Area * pContext);
-
 
 void Graph::ComputeChokePointDistanceMatrix()
 {
-	// 1) Size the matrix
-	m_ChokePointDistanceMatrix.clear();
-	m_ChokePointDistanceMatrix.resize(m_ChokePointList.size());
-	for (auto & line : m_ChokePointDistanceMatrix)
+	m_chokePointDistanceMatrixStale = false;
+
+	// 1) Size the matrices (flat, row-major: Cf. MatrixIndex)
+	bwem_assert(ChokePointCount() <= numeric_limits<CPPathView::hop>::max());
+	m_ChokePointDistanceMatrix.assign(ChokePointCount() * ChokePointCount(), -1);
+	m_ChokePointNextHops.assign(ChokePointCount() * ChokePointCount(), CPPathView::none);
+	// 2) Compute distances inside each Area, using the distance fields of its ChokePoints (Cf. Area::ChokePointDistanceField).
+	//    The Areas are independent, so they are processed concurrently (one task per Area, and each search uses
+	//    its own thread_local scratch), then the results are merged in the order of the Areas, like a sequential run would.
+	vector<vector<DistancesFrom>> AreaResults(Areas().size());
+	parallel_for(0, AreasCount(), [this, &AreaResults](int i)
 	{
-		line.resize(m_ChokePointList.size(), -1);
-	}
-
-	m_PathsBetweenChokePoints.clear();
-	m_PathsBetweenChokePoints.resize(m_ChokePointList.size());
-	for (auto & line : m_PathsBetweenChokePoints)
-	{
-		line.resize(m_ChokePointList.size());
-	}
-	// 2) Compute distances inside each Area
-	for (const Area & area : Areas())
-	{
-		ComputeChokePointDistances(&area);
-	}
+		m_Areas[i].ComputeChokePointDistanceFields();
+		for (const ChokePoint * pStart : m_Areas[i].ChokePoints())
+			AreaResults[i].push_back(ComputeDistancesFrom(&m_Areas[i], pStart));
+	});
+
+	for (const vector<DistancesFrom> & Results : AreaResults)
+		for (const DistancesFrom & Result : Results)
+			SetDistancesFrom(Result);
 	// 3) Compute distances through connected Areas
 	ComputeChokePointDistances(this);
 
 	for (const ChokePoint * cp : ChokePoints())
 	{
 		SetDistance(cp, cp, 0);
-		SetPath(cp, cp, CPPath{cp});
+		SetPath(cp, cp, cp, cp);
 	}
 
 	// 4) Update Area::m_AccessibleNeighbours for each Area
@@ -317,32 +366,184 @@ void Graph::ComputeChokePointDistanceMatrix()
 }
 
 
+// Cheaper than ComputeChokePointDistanceMatrix after a blocking Neutral was destroyed, as only the Areas around the Neutral
+// need new distance fields. Destroying a Neutral can only make the Areas larger and unblock ChokePoints, so the distances
+// can only decrease and the matrix can be updated in place:
+//	- each ChokePoint newly unblocked is used as a new intermediate step (one pivot step of Floyd-Warshall's algorithm).
+//	- each intra-Area distance that decreased is used as a new shortcut between its two ChokePoints.
+// If some intra-Area distance increased instead (the Tile a distance field starts from may have moved), the whole matrix is recomputed.
+// So is it if some Tiles changed before, while the paths were not updated (Cf. InvalidateChokePointDistanceMatrix).
+void Graph::UpdateChokePointDistanceMatrix(const vector<TileCoord> & ChangedTiles, const vector<const ChokePoint *> & UnblockedChokePoints)
+{
+	if (m_chokePointDistanceMatrixStale || (m_ChokePointDistanceMatrix.size() != m_ChokePointList.size() * m_ChokePointList.size()))
+		return ComputeChokePointDistanceMatrix();
+
+	// 1) Find the Areas whose distance fields may have changed: the ones containing a changed Tile, or reaching a Tile next to it.
+	vector<bool> Changed(AreasCount() + 1, false);		// index == Area::id
+	for (const TileCoord & t : ChangedTiles)
+	{
+		const Area::id id = GetMap()->GetTile(TilePosition(t)).AreaId();
+		if (Valid(id)) Changed[id] = true;
+	}
+
+	for (const Area & area : Areas())
+		for (const DistanceField & Field : area.ChokePointDistanceFields())
+			for (const TileCoord & t : ChangedTiles)
+				if ((Field.TopLeft().x - 1 <= t.x) && (t.x <= Field.TopLeft().x + Field.Width()) &&
+					(Field.TopLeft().y - 1 <= t.y) && (t.y <= Field.TopLeft().y + Field.Height()))
+					Changed[area.Id()] = true;
+
+	vector<Area *> ChangedAreas;
+	for (Area & area : Areas())
+		if (Changed[area.Id()]) ChangedAreas.push_back(&area);
+
+	// 2) Recompute their distance fields, keeping the intra-Area distances before and after.
+	vector<vector<int>> OldDistances(ChangedAreas.size());
+	vector<vector<int>> NewDistances(ChangedAreas.size());
+	parallel_for(0, int(ChangedAreas.size()), [this, &ChangedAreas, &OldDistances, &NewDistances](int i)
+	{
+		OldDistances[i] = IntraAreaDistances(*ChangedAreas[i]);
+		ChangedAreas[i]->ComputeChokePointDistanceFields();
+		NewDistances[i] = IntraAreaDistances(*ChangedAreas[i]);
+	});
+
+	for (int i = 0 ; i < (int)ChangedAreas.size() ; ++i)
+		for (int k = 0 ; k < (int)OldDistances[i].size() ; ++k)
+			if (OldDistances[i][k] && (!NewDistances[i][k] || (NewDistances[i][k] > OldDistances[i][k])))
+				return ComputeChokePointDistanceMatrix();
+
+	// 3) Relax the paths through the ChokePoints newly unblocked.
+	for (const ChokePoint * cp : UnblockedChokePoints)
+		RelaxThrough(cp);
+
+	// 4) Relax the paths through the intra-Area distances that decreased (same pairs and order as IntraAreaDistances).
+	for (int i = 0 ; i < (int)ChangedAreas.size() ; ++i)
+	{
+		const vector<const ChokePoint *> & AreaChokePoints = ChangedAreas[i]->ChokePoints();
+		int k = 0;
+		for (int u = 0 ; u < (int)AreaChokePoints.size() ; ++u)
+			for (int v = 0 ; v < u ; ++v, ++k)
+			{
+				const int newDist = NewDistances[i][k];
+				const int existingDist = Distance(AreaChokePoints[u], AreaChokePoints[v]);
+				if (newDist && ((existingDist == -1) || (newDist < existingDist)))
+					RelaxThroughEdge(AreaChokePoints[u], AreaChokePoints[v], newDist);
+			}
+	}
+
+	// 5) Same as ComputeChokePointDistanceMatrix
+	for (Area & area : Areas())
+		area.UpdateAccessibleNeighbours();
+
+	UpdateGroupIds();
+}
+
+
+// Returns the distances between the ChokePoints of area (0 if unreachable), for each pair (u, v) such that v precedes u in area.ChokePoints().
+vector<int> Graph::IntraAreaDistances(const Area & area) const
+{
+	vector<int> Distances;
+	for (const ChokePoint * pStart : area.ChokePoints())
+	{
+		vector<const ChokePoint *> Targets;
+		for (const ChokePoint * cp : area.ChokePoints())
+		{
+			if (cp == pStart) break;
+			Targets.push_back(cp);
+		}
+
+		const vector<int> DistancesFromStart = area.ComputeDistances(pStart, Targets);
+		Distances.insert(Distances.end(), DistancesFromStart.begin(), DistancesFromStart.end());
+	}
+
+	return Distances;
+}
+
+
+// Uses the new direct distance distUV between cpU and cpV as a shortcut for the paths between any pair of ChokePoints (a, b):
+// a ... cpU cpV ... b. As in Graph::ComputeDistances, blocked ChokePoints can only be the ends of a path.
+void Graph::RelaxThroughEdge(const ChokePoint * cpU, const ChokePoint * cpV, int distUV)
+{
+	for (const ChokePoint * a : ChokePoints())
+	{
+		const int distAU = Distance(a, cpU);
+		if ((distAU == -1) || (cpU->Blocked() && (a != cpU))) continue;
+
+		for (const ChokePoint * b : ChokePoints())
+		{
+			const int distVB = Distance(cpV, b);
+			if ((a == b) || (distVB == -1) || (cpV->Blocked() && (b != cpV))) continue;
+
+			Improve(a, b, distAU + distUV + distVB, (a == cpU) ? cpV : NextHop(a, cpU), (b == cpV) ? cpU : NextHop(b, cpV));
+		}
+	}
+}
+
+
+// Uses pivot as a new intermediate step for the paths between any pair of ChokePoints (a, b): a ... pivot ... b.
+void Graph::RelaxThrough(const ChokePoint * pivot)
+{
+	for (const ChokePoint * a : ChokePoints())
+	{
+		const int distAP = Distance(a, pivot);
+		if ((a == pivot) || (distAP == -1)) continue;
+
+		for (const ChokePoint * b : ChokePoints())
+		{
+			const int distPB = Distance(pivot, b);
+			if ((b == pivot) || (a == b) || (distPB == -1)) continue;
+
+			Improve(a, b, distAP + distPB, NextHop(a, pivot), NextHop(b, pivot));
+		}
+	}
+}
+
+
+// Keeps dist and the path afterA ... beforeB if dist is shorter than the distance already known between cpA and cpB.
+void Graph::Improve(const ChokePoint * cpA, const ChokePoint * cpB, int dist, const ChokePoint * afterA, const ChokePoint * beforeB)
+{
+	const int existingDist = Distance(cpA, cpB);
+	if ((existingDist == -1) || (dist < existingDist))
+	{
+		SetDistance(cpA, cpB, dist);
+		SetPath(cpA, cpB, afterA, beforeB);
+	}
+}
+
+
+// Context == Area: the ChokePoints of pArea are directly connected, so the paths are {start, Targets[i]}.
+vector<int> Graph::ComputeDistances(const Area * pArea, const ChokePoint * start, const vector<const ChokePoint *> & Targets,
+									vector<const ChokePoint *> & FirstHops, vector<const ChokePoint *> & LastHops) const
+{
+	FirstHops = Targets;
+	LastHops.assign(Targets.size(), start);
+
+	return pArea->ComputeDistances(start, Targets);
+}
+
+
 // Returns Distances such that Distances[i] == ground_distance(start, Targets[i]) in pixels
 // Any Distances[i] may be 0 (meaning Targets[i] is not reachable).
 // This may occur in the case where start and Targets[i] leave in different continents or due to Bloqued intermediate ChokePoint(s).
-// For each reached target, the shortest path can be derived using
-// the backward trace set in cp->PathBackTrace() for each intermediate ChokePoint cp from the target.
+// For each reached target, FirstHops[i] and LastHops[i] are the second and the second to last ChokePoints
+// of the shortest path from start to Targets[i].
 // Note: same algo than Area::ComputeDistances (derived from Dijkstra)
-vector<int> Graph::ComputeDistances(const ChokePoint * start, const vector<const ChokePoint *> & Targets) const
+vector<int> Graph::ComputeDistances(const Graph *, const ChokePoint * start, const vector<const ChokePoint *> & Targets,
+									vector<const ChokePoint *> & FirstHops, vector<const ChokePoint *> & LastHops) const
 {
-	const MapImpl * pMap = GetMap();
 	vector<int> Distances(Targets.size());
+	FirstHops.assign(Targets.size(), nullptr);
+	LastHops.assign(Targets.size(), nullptr);
 
-	Tile::UnmarkAll();
-
-	multimap<int, const ChokePoint *> ToVisit;	// a priority queue holding the GetChokePoints to visit ordered by their distance to start.
-	ToVisit.emplace(0, start);
+	static thread_local ShortestPathSearch<const ChokePoint *> Search;
+	Search.Begin(int(m_ChokePointList.size()));
+	Search.Relax(start->Index(), start, 0);
 
 	int remainingTargets = Targets.size();
-	while (!ToVisit.empty())
+	while (!Search.Empty())
 	{
-		int currentDist = ToVisit.begin()->first;
-		const ChokePoint * current = ToVisit.begin()->second;
-		const Tile & currentTile = pMap->GetTile(TilePosition(current->Center()), check_t::no_check);
-		bwem_assert(currentTile.InternalData() == currentDist);
-		ToVisit.erase(ToVisit.begin());
-		currentTile.SetInternalData(0);										// resets Tile::m_internalData for future usage
-		currentTile.SetMarked();
+		const ChokePoint * current = Search.Node(Search.Pop());
+		const int currentDist = Search.Distance(current->Index());
 
 		for (int i = 0 ; i < (int)Targets.size() ; ++i)
 			if (current == Targets[i])
@@ -356,48 +557,58 @@ vector<int> Graph::ComputeDistances(const ChokePoint * start, const vector<const
 
 		for (const Area * pArea : {current->GetAreas().first, current->GetAreas().second})
 			for (const ChokePoint * next : pArea->ChokePoints())
-				if (next != current)
-				{
-					const int newNextDist = currentDist + Distance(current, next);
-					const Tile & nextTile = pMap->GetTile(TilePosition(next->Center()), check_t::no_check); 
-					if (!nextTile.Marked())
-					{
-						if (nextTile.InternalData())	// next already in ToVisit
-						{
-							if (newNextDist < nextTile.InternalData())		// nextNewDist < nextOldDist
-							{	// To update next's distance, we need to remove-insert it from ToVisit:
-								auto range = ToVisit.equal_range(nextTile.InternalData());
-								auto iNext = find_if(range.first, range.second, [next]
-									(const pair<int, const ChokePoint *> & e) { return e.second == next; });
-								bwem_assert(iNext != range.second);
-
-								ToVisit.erase(iNext);
-								nextTile.SetInternalData(newNextDist);
-								next->SetPathBackTrace(current);
-								ToVisit.emplace(newNextDist, next);
-							}
-						}
-						else
-						{
-							nextTile.SetInternalData(newNextDist);
-							next->SetPathBackTrace(current);
-							ToVisit.emplace(newNextDist, next);
-						}
-					}
-				}
+				if ((next != current) && (Distance(current, next) >= 0))		// -1: no path between them inside pArea
+					Search.Relax(next->Index(), next, currentDist + Distance(current, next), current->Index());
 	}
 
 //	bwem_assert(!remainingTargets);
 
-	// Reset Tile::m_internalData for future usage
-	for (auto e : ToVisit)
-		pMap->GetTile(TilePosition(e.second->Center()), check_t::no_check).SetInternalData(0);	
-	
+	// Find the ends of the paths from the backward traces.
+	// An edge of the trace is a distance of the matrix, which may already be a path through other ChokePoints,
+	// so the hops are taken from the matrix (where that path is stored) rather than from the trace:
+	for (int i = 0 ; i < (int)Targets.size() ; ++i)
+		if (Search.Closed(Targets[i]->Index()))
+		{
+			int cp = Targets[i]->Index();
+			LastHops[i] = NextHop(Targets[i], Search.Node(Search.Parent(cp)));
+			while (Search.Parent(cp) != start->Index()) cp = Search.Parent(cp);
+			FirstHops[i] = NextHop(start, Search.Node(cp));
+		}
+
 	return Distances;
 }
 
 
-const CPPath & Graph::GetPath(const Position & a, const Position & b, int * pLength) const
+// The length of Path, the shortest path from a to b at the ChokePoint level (Cf. GetPath).
+// minDist_A_B is the distance from a to b through the first and the last ChokePoints of Path.
+static int pathLength(const Position & a, const Position & b, const CPPath & Path, int minDist_A_B)
+{
+	bwem_assert(!Path.empty());
+
+	int length = minDist_A_B;
+
+	if (Path.front() == Path.back())		// Path.size() == 1
+	{
+		const ChokePoint * cp = Path.front();
+
+		Position cpEnd1 = center(cp->Pos(ChokePoint::end1));
+		Position cpEnd2 = center(cp->Pos(ChokePoint::end2));
+		if (intersect(a.x, a.y, b.x, b.y, cpEnd1.x, cpEnd1.y, cpEnd2.x, cpEnd2.y))
+			length = a.getApproxDistance(b);
+		else
+			for (ChokePoint::node node : {ChokePoint::end1, ChokePoint::end2})
+			{
+				Position c = center(cp->Pos(node));
+				int dist_A_B = a.getApproxDistance(c) + b.getApproxDistance(c);
+				if (dist_A_B < length) length = dist_A_B;
+			}
+	}
+
+	return length;
+}
+
+
+CPPath Graph::GetPath(const Position & a, const Position & b, int * pLength) const
 {
 	const Area * pAreaA = GetNearestArea(WalkPosition(a));
 	const Area * pAreaB = GetNearestArea(WalkPosition(b));
@@ -405,13 +616,13 @@ const CPPath & Graph::GetPath(const Position & a, const Position & b, int * pLen
 	if (pAreaA == pAreaB)
 	{
 		if (pLength) *pLength = a.getApproxDistance(b);
-		return m_EmptyPath;
+		return CPPath();
 	};
 		
 	if (!pAreaA->AccessibleFrom(pAreaB))
 	{
 		if (pLength) *pLength = -1;
-		return m_EmptyPath;
+		return CPPath();
 	};
 
 	int minDist_A_B = numeric_limits<int>::max();
@@ -437,34 +648,611 @@ const CPPath & Graph::GetPath(const Position & a, const Position & b, int * pLen
 
 	bwem_assert(minDist_A_B != numeric_limits<int>::max());
 
-	const CPPath & Path = GetPath(pBestCpA, pBestCpB);
+	const CPPath Path = GetPath(pBestCpA, pBestCpB);
+
+	if (pLength) *pLength = pathLength(a, b, Path, minDist_A_B);
+
+	return Path;
+}
+
 
-	if (pLength)
+// Cf. Map::GetPaths
+// The queries are sorted by pair of Areas (pAreaA, pAreaB). For each group, the unblocked ChokePoints of pAreaA and pAreaB,
+// their centers and the distances between them are gathered once into contiguous arrays.
+// Then, for each query, the rows of cpA that cannot beat the best pair found so far are skipped,
+// using a lower bound of the distances of the row. As ties are broken like in GetPath, the results are exactly the same.
+void Graph::GetPaths(Span<const Position> From, Span<const Position> To, Span<CPPath> Paths, Span<int> Lengths) const
+{
+	bwem_assert((From.size() == To.size()) && (Paths.size() == From.size()));
+	bwem_assert(Lengths.empty() || (Lengths.size() == From.size()));
+
+	const int count = int(From.size());
+
+	// 1) Sort the queries by pair of Areas:
+	static thread_local vector<pair<uint32_t, int>> Queries;		// (key of the pair of Areas, index of the query)
+	static thread_local vector<const Area *> QueryAreas;			// index == 2 * index of the query (+ 1 for b)
+	Queries.resize(count);
+	QueryAreas.resize(2 * count);
+	for (int i = 0 ; i < count ; ++i)
 	{
-		bwem_assert(Path.size() >= 1);
+		// GetNearestArea can be slow outside the Areas, so its result is reused when the positions repeat
+		// (typically, many units sent to the same target):
+		const bool sameA = (i > 0) && (WalkPosition(From[i]) == WalkPosition(From[i-1]));
+		const bool sameB = (i > 0) && (WalkPosition(To[i]) == WalkPosition(To[i-1]));
+		const Area * pAreaA = QueryAreas[2*i] = sameA ? QueryAreas[2*i - 2] : GetNearestArea(WalkPosition(From[i]));
+		const Area * pAreaB = QueryAreas[2*i + 1] = sameB ? QueryAreas[2*i - 1] : GetNearestArea(WalkPosition(To[i]));
+		Queries[i] = make_pair(uint32_t(pAreaA->Id()) << 16 | uint32_t(pAreaB->Id()), i);
+	}
+	sort(Queries.begin(), Queries.end());
 
-		*pLength = minDist_A_B;
+	static thread_local vector<int> Groups;							// the first query of each group, followed by count
+	Groups.clear();
+	for (int i = 0 ; i < count ; ++i)
+		if ((i == 0) || (Queries[i].first != Queries[i-1].first)) Groups.push_back(i);
+	Groups.push_back(count);
 
-		if (Path.size() == 1)
+	// 2) Solve each group:
+	const auto solveGroup = [&, this](int g)
+	{
+		const int first = Groups[g];
+		const int last = Groups[g+1];
+		const Area * pAreaA = QueryAreas[2 * Queries[first].second];
+		const Area * pAreaB = QueryAreas[2 * Queries[first].second + 1];
+
+		if ((pAreaA == pAreaB) || !pAreaA->AccessibleFrom(pAreaB))
 		{
-			bwem_assert(pBestCpA == pBestCpB);
-			const ChokePoint * cp = pBestCpA;
-
-			Position cpEnd1 = center(cp->Pos(ChokePoint::end1));
-			Position cpEnd2 = center(cp->Pos(ChokePoint::end2));
-			if (intersect(a.x, a.y, b.x, b.y, cpEnd1.x, cpEnd1.y, cpEnd2.x, cpEnd2.y))
-				*pLength = a.getApproxDistance(b);
-			else
-				for (ChokePoint::node node : {ChokePoint::end1, ChokePoint::end2})
+			for (int k = first ; k < last ; ++k)
+			{
+				const int i = Queries[k].second;
+				Paths[i] = CPPath();
+				if (!Lengths.empty()) Lengths[i] = (pAreaA == pAreaB) ? From[i].getApproxDistance(To[i]) : -1;
+			}
+			return;
+		}
+
+		static thread_local vector<const ChokePoint *> CpsA, CpsB;
+		static thread_local vector<Position> CentersA, CentersB;
+		static thread_local vector<int> Distances;		// index == iA * CpsB.size() + iB
+		static thread_local vector<int> MinDistances;	// index == iA: the min of the row iA of Distances
+		static thread_local vector<int> DistancesToB;	// index == iB: the distances from the current b to CentersB
+
+		const auto gather = [](const Area * pArea, vector<const ChokePoint *> & Cps, vector<Position> & Centers)
+		{
+			Cps.clear();
+			Centers.clear();
+			for (const ChokePoint * cp : pArea->ChokePoints()) if (!cp->Blocked())
+			{
+				Cps.push_back(cp);
+				Centers.push_back(Position(cp->Center()));
+			}
+		};
+		gather(pAreaA, CpsA, CentersA);
+		gather(pAreaB, CpsB, CentersB);
+
+		const int sizeA = int(CpsA.size());
+		const int sizeB = int(CpsB.size());
+		Distances.resize(sizeA * sizeB);
+		MinDistances.assign(sizeA, numeric_limits<int>::max());
+		DistancesToB.resize(sizeB);
+		for (int iA = 0 ; iA < sizeA ; ++iA)
+		for (int iB = 0 ; iB < sizeB ; ++iB)
+		{
+			const int d = Distances[iA * sizeB + iB] = Distance(CpsA[iA], CpsB[iB]);
+			MinDistances[iA] = min(MinDistances[iA], d);
+		}
+
+		for (int k = first ; k < last ; ++k)
+		{
+			const int i = Queries[k].second;
+			const Position & a = From[i];
+			const Position & b = To[i];
+
+			int minDist_B = numeric_limits<int>::max();
+			for (int iB = 0 ; iB < sizeB ; ++iB)
+				minDist_B = min(minDist_B, DistancesToB[iB] = b.getApproxDistance(CentersB[iB]));
+
+			int minDist_A_B = numeric_limits<int>::max();
+			int bestA = -1;
+			int bestB = -1;
+			for (int iA = 0 ; iA < sizeA ; ++iA)
+			{
+				const int dist_A_cpA = a.getApproxDistance(CentersA[iA]);
+				if (dist_A_cpA + MinDistances[iA] + minDist_B >= minDist_A_B) continue;		// no pair of this row can be better
+
+				const int * pRow = &Distances[iA * sizeB];
+				for (int iB = 0 ; iB < sizeB ; ++iB)
 				{
-					Position c = center(cp->Pos(node));
-					int dist_A_B = a.getApproxDistance(c) + b.getApproxDistance(c);
-					if (dist_A_B < *pLength) *pLength = dist_A_B;
+					const int dist_A_B = dist_A_cpA + DistancesToB[iB] + pRow[iB];
+					if (dist_A_B < minDist_A_B)
+					{
+						minDist_A_B = dist_A_B;
+						bestA = iA;
+						bestB = iB;
+					}
 				}
+			}
+
+			bwem_assert(bestA != -1);
+
+			Paths[i] = GetPath(CpsA[bestA], CpsB[bestB]);
+			if (!Lengths.empty()) Lengths[i] = pathLength(a, b, Paths[i], minDist_A_B);
+		}
+	};
+
+	const int groupCount = int(Groups.size()) - 1;
+	for (int g = 0 ; g < groupCount ; ++g)
+		solveGroup(g);
+}
+
+
+// Ground distances between Tiles (Cf. GetGroundDistance and ComputeGroundDistanceField):
+// the moves are between 8-connected walkable Tiles, and cost 32 pixels (orthogonal) or 45 pixels (diagonal, ~ 32 x sqrt(2)).
+static const int orthogonal_move = 32;
+static const int diagonal_move = 45;
+
+static bool groundWalkable(const Tile & tile)
+{
+	return (tile.AreaId() > 0) || (tile.AreaId() == -1);		// excludes the unwalkable Tiles and the ones under blocking Neutrals
+}
+
+// The ground distance between a and b if there were no obstacle.
+static int octileDistance(TileCoord a, TileCoord b)
+{
+	const int dx = abs(a.x - b.x);
+	const int dy = abs(a.y - b.y);
+	return orthogonal_move * abs(dx - dy) + diagonal_move * min(dx, dy);
+}
+
+
+// Returns the nearest walkable Tile (Cf. groundWalkable).
+TileCoord Graph::NearestWalkableTile(const TilePosition & t) const
+{
+	return TileCoord(GetMap()->BreadthFirstSearch(TilePosition(TileCoord(t)),
+		[](const Tile & tile, TilePosition) { return groundWalkable(tile); },	// findCond
+		[](const Tile &, TilePosition) { return true; }));						// visitCond
+}
+
+
+int Graph::GetGroundDistance(const Position & a, const Position & b) const
+{
+	const TileCoord start = NearestWalkableTile(TilePosition(a));
+	const TileCoord target = NearestWalkableTile(TilePosition(b));
+	if (start == target) return 0;
+
+	// The Areas tell whether target is accessible from start at all, which avoids searching the whole continent of start.
+	const Area * pAreaA = GetNearestArea(TilePosition(start));
+	const Area * pAreaB = GetNearestArea(TilePosition(target));
+	if (!pAreaA || !pAreaB || !pAreaA->AccessibleFrom(pAreaB)) return -1;
+
+	return SearchTilePath(start, target, nullptr);
+}
+
+
+// A* over the walkable Tiles, using the ALT heuristic:
+// for any landmark L, |d(L, target) - d(L, t)| <= d(t, target) (triangle inequality), and so is the octile distance.
+// The largest of these lower bounds is a consistent heuristic, so that the first time the target is closed, its distance is exact.
+// Returns the ground distance from start to target, or -1 if target is not accessible from start.
+// If pPath != nullptr, the Tiles of the path (start and target included) are appended to *pPath.
+int Graph::SearchTilePath(TileCoord start, TileCoord target, TilePath * pPath) const
+{
+	const Map * pMap = GetMap();
+
+	// 1) Keep the landmarks giving the best lower bounds between start and target.
+	pair<int, const DistanceField *> Active[max_active_landmarks];		// (bound, landmark), best first
+	int activeCount = 0;
+	for (const DistanceField & Landmark : m_Landmarks)
+	{
+		const int toStart = Landmark.Distance(start);
+		const int toTarget = Landmark.Distance(target);
+		if ((toStart == -1) != (toTarget == -1)) return -1;		// one is reached by the landmark, the other is not
+		if (toStart == -1) continue;
+
+		const int bound = abs(toStart - toTarget);
+		int i = min(activeCount, max_active_landmarks - 1);
+		if ((i < activeCount) && (bound <= Active[i].first)) continue;
+		for ( ; (i > 0) && (Active[i-1].first < bound) ; --i) Active[i] = Active[i-1];
+		Active[i] = make_pair(bound, &Landmark);
+		activeCount = min(activeCount + 1, max_active_landmarks);
+	}
+
+	for (int i = 0 ; i < activeCount ; ++i)
+		Active[i].first = Active[i].second->Distance(target);		// now the distance from the landmark to target
+
+	const auto heuristic = [&Active, activeCount, target](TileCoord t)
+	{
+		int h = octileDistance(t, target);
+		for (int i = 0 ; i < activeCount ; ++i)
+		{
+			const int toT = Active[i].second->Distance(t);
+			if (toT != -1) h = max(h, abs(Active[i].first - toT));
+		}
+		return h;
+	};
+
+	// 2) A*: the nodes are the Tiles, identified by their index in Map::Tiles(), and store their ground distance from start,
+	//    while the distances of the search are the estimates f = distance from start + heuristic.
+	const int width = static_cast<int>(pMap->Size().x);
+	const int height = static_cast<int>(pMap->Size().y);
+	const int targetIndex = target.y * width + target.x;
+
+	static thread_local ShortestPathSearch<int> Search;
+	Search.Begin(width * height);
+	Search.Relax(start.y * width + start.x, 0, heuristic(start));
+
+	while (!Search.Empty())
+	{
+		const int c = Search.Pop();
+		const int currentDist = Search.Node(c);
+		if (c == targetIndex)
+		{
+			if (pPath)		// build the path from the backward trace
+			{
+				const size_t first = pPath->Tiles().size();
+				for (int t = c ; t != -1 ; t = Search.Parent(t))
+					pPath->Tiles().emplace_back(int16_t(t % width), int16_t(t / width));
+				reverse(pPath->Tiles().begin() + first, pPath->Tiles().end());
+			}
+			return currentDist;
+		}
+
+		const TileCoord current(int16_t(c % width), int16_t(c / width));
+		for (int dy = -1 ; dy <= +1 ; ++dy)
+		for (int dx = -1 ; dx <= +1 ; ++dx)
+		{
+			const TileCoord next(int16_t(current.x + dx), int16_t(current.y + dy));
+			if ((dx == 0 && dy == 0) || (next.x < 0) || (next.y < 0) || (next.x >= width) || (next.y >= height)) continue;
+
+			const int n = next.y * width + next.x;
+			const int newNextDist = currentDist + ((dx && dy) ? diagonal_move : orthogonal_move);
+			if (Search.Reached(n))
+			{
+				if (Search.Closed(n) || (newNextDist >= Search.Node(n))) continue;
+				Search.Relax(n, newNextDist, newNextDist + (Search.Distance(n) - Search.Node(n)), c);		// same heuristic as before
+			}
+			else if (groundWalkable(pMap->Tiles()[n]))
+				Search.Relax(n, newNextDist, newNextDist + heuristic(next), c);
 		}
 	}
 
-	return GetPath(pBestCpA, pBestCpB);
+	return -1;
+}
+
+
+// Hierarchical path finding (HPA*): the Areas are the clusters and the ChokePoints are the portals between them.
+//	1) The abstract path is the sequence of ChokePoints cpA ... cpB minimizing
+//	   distance(start, cpA) + Distance(cpA, cpB) + distance(cpB, target), where the distances to the ChokePoints
+//	   are read from the distance fields of the Areas of start and target (Cf. Area::ChokePointDistanceField).
+//	2) Each leg inside an Area is refined without any search, by descending the distance field of the ChokePoint it leads to.
+//	   Only the crossings of the ChokePoints (a few Tiles between their positions in their two Areas) are searched with A*.
+// If start and target are in the same Area, or if the abstract path cannot be refined, a single A* is used (Cf. SearchTilePath).
+int Graph::GetTilePath(const Position & a, const Position & b, TilePath & Path) const
+{
+	Path.Clear();
+
+	const TileCoord start = NearestWalkableTile(TilePosition(a));
+	const TileCoord target = NearestWalkableTile(TilePosition(b));
+	if (start == target)
+	{
+		Path.Add(start);
+		Path.SetLength(0);
+		return 0;
+	}
+
+	const Area * pAreaA = GetNearestArea(TilePosition(start));
+	const Area * pAreaB = GetNearestArea(TilePosition(target));
+	if (!pAreaA || !pAreaB || !pAreaA->AccessibleFrom(pAreaB)) return -1;
+
+	if ((pAreaA == pAreaB) || !RefineTilePath(start, pAreaA, target, pAreaB, Path))
+	{
+		Path.Clear();
+		if (SearchTilePath(start, target, &Path) == -1) return -1;
+	}
+
+	// The length is measured on the Tiles, like in SearchTilePath:
+	int length = 0;
+	for (int i = 1 ; i < Path.size() ; ++i)
+		length += ((Path.Tiles()[i].x != Path.Tiles()[i-1].x) && (Path.Tiles()[i].y != Path.Tiles()[i-1].y)) ? diagonal_move : orthogonal_move;
+
+	Path.SetLength(length);
+	return length;
+}
+
+
+// Cf. GetTilePath. Returns false if the abstract path cannot be refined.
+bool Graph::RefineTilePath(TileCoord start, const Area * pAreaA, TileCoord target, const Area * pAreaB, TilePath & Path) const
+{
+	// 1) The best pair of ChokePoints (cpA, cpB):
+	int minDist_A_B = numeric_limits<int>::max();
+	const ChokePoint * pBestCpA = nullptr;
+	const ChokePoint * pBestCpB = nullptr;
+
+	for (const ChokePoint * cpA : pAreaA->ChokePoints()) if (!cpA->Blocked())
+	{
+		const int dist_A_cpA = pAreaA->ChokePointDistanceField(cpA).Distance(start);
+		if (dist_A_cpA == -1) continue;
+
+		for (const ChokePoint * cpB : pAreaB->ChokePoints()) if (!cpB->Blocked() && (Distance(cpA, cpB) >= 0))
+		{
+			const int dist_B_cpB = pAreaB->ChokePointDistanceField(cpB).Distance(target);
+			if (dist_B_cpB == -1) continue;
+
+			const int dist_A_B = dist_A_cpA + Distance(cpA, cpB) + dist_B_cpB;
+			if (dist_A_B < minDist_A_B)
+			{
+				minDist_A_B = dist_A_B;
+				pBestCpA = cpA;
+				pBestCpB = cpB;
+			}
+		}
+	}
+
+	if (!pBestCpA) return false;
+
+	// 2) Refine each leg:
+	Path.Add(start);
+	const Area * pArea = pAreaA;		// the Area we are walking in
+	const ChokePoint * cpPrevious = nullptr;
+	for (const ChokePoint * cp : GetPath(pBestCpA, pBestCpB))
+	{
+		if (cpPrevious)		// cpPrevious and cp both belong to the next Area
+		{
+			const Area * pNextArea = (cpPrevious->GetAreas().first != pArea) ? cpPrevious->GetAreas().first : cpPrevious->GetAreas().second;
+			if ((pNextArea != cp->GetAreas().first) && (pNextArea != cp->GetAreas().second)) return false;
+
+			// Cross cpPrevious:
+			const TileCoord from = pArea->ChokePointDistanceField(cpPrevious).Origin();
+			const TileCoord to = pNextArea->ChokePointDistanceField(cpPrevious).Origin();
+			if (Path.Tiles().back() != from) return false;
+			Path.Tiles().pop_back();
+			if (SearchTilePath(from, to, &Path) == -1) return false;
+			pArea = pNextArea;
+		}
+
+		// Walk to cp inside pArea:
+		if (!DescendDistanceField(pArea->ChokePointDistanceField(cp), Path)) return false;
+		cpPrevious = cp;
+	}
+
+	// 3) Cross cpB and walk to target, descending the distance field of cpB from target then reversing that part:
+	if (pArea != pAreaB)
+	{
+		const TileCoord from = pArea->ChokePointDistanceField(pBestCpB).Origin();
+		const TileCoord to = pAreaB->ChokePointDistanceField(pBestCpB).Origin();
+		if (Path.Tiles().back() != from) return false;
+		Path.Tiles().pop_back();
+		if (SearchTilePath(from, to, &Path) == -1) return false;
+	}
+
+	const size_t first = Path.Tiles().size();
+	Path.Tiles().push_back(target);
+	if (!DescendDistanceField(pAreaB->ChokePointDistanceField(pBestCpB), Path)) return false;
+	Path.Tiles().pop_back();		// the Origin of the distance field, already in Path
+	reverse(Path.Tiles().begin() + first, Path.Tiles().end());
+
+	return true;
+}
+
+
+// Appends the Tiles from Path.Tiles().back() (excluded) to Field.Origin() (included), each one being the neighbour
+// the nearest to Field.Origin(). This follows a shortest path inside the Area of Field, since Field was computed by Dijkstra's algorithm.
+// Returns false if Path.Tiles().back() is not reached by Field.
+bool Graph::DescendDistanceField(const DistanceField & Field, TilePath & Path) const
+{
+	TileCoord current = Path.Tiles().back();
+	int currentDist = Field.Distance(current);
+	if (currentDist == -1) return false;
+
+	while (currentDist > 0)
+	{
+		TileCoord best = current;
+		int bestDist = currentDist;
+		int bestEstimate = numeric_limits<int>::max();
+		for (int dy = -1 ; dy <= +1 ; ++dy)
+		for (int dx = -1 ; dx <= +1 ; ++dx)
+		{
+			const TileCoord next(int16_t(current.x + dx), int16_t(current.y + dy));
+			const int nextDist = Field.Distance(next);
+			if ((nextDist == -1) || (nextDist >= currentDist)) continue;
+
+			const int estimate = nextDist + ((dx && dy) ? diagonal_move : orthogonal_move);
+			if (estimate < bestEstimate)
+			{
+				bestEstimate = estimate;
+				best = next;
+				bestDist = nextDist;
+			}
+		}
+
+		if (best == current) return false;
+		Path.Tiles().push_back(best);
+		current = best;
+		currentDist = bestDist;
+	}
+
+	return true;
+}
+
+
+// Returns the ground distances in pixels from origin to each walkable Tile of the Map (Dijkstra's algorithm, Cf. GetGroundDistance).
+DistanceField Graph::ComputeGroundDistanceField(TileCoord origin) const
+{
+	const Map * pMap = GetMap();
+	const int width = static_cast<int>(pMap->Size().x);
+	const int height = static_cast<int>(pMap->Size().y);
+
+	static thread_local ShortestPathSearch<TileCoord> Search;
+	Search.Begin(width * height);
+	Search.Relax(origin.y * width + origin.x, origin, 0);
+
+	TileCoord topLeft = origin;
+	TileCoord bottomRight = origin;
+	while (!Search.Empty())
+	{
+		const int c = Search.Pop();
+		const TileCoord current = Search.Node(c);
+		const int currentDist = Search.Distance(c);
+		makeBoundingBoxIncludePoint(topLeft, bottomRight, current);
+
+		for (int dy = -1 ; dy <= +1 ; ++dy)
+		for (int dx = -1 ; dx <= +1 ; ++dx)
+		{
+			const TileCoord next(int16_t(current.x + dx), int16_t(current.y + dy));
+			if ((dx == 0 && dy == 0) || (next.x < 0) || (next.y < 0) || (next.x >= width) || (next.y >= height)) continue;
+
+			const int n = next.y * width + next.x;
+			if (Search.Reached(n) || groundWalkable(pMap->Tiles()[n]))
+				Search.Relax(n, next, currentDist + ((dx && dy) ? diagonal_move : orthogonal_move));
+		}
+	}
+
+	// All the Tiles reached are closed, and they all lie in [topLeft, bottomRight]:
+	DistanceField Field(origin, topLeft, bottomRight.x - topLeft.x + 1, bottomRight.y - topLeft.y + 1);
+	for (int16_t y = topLeft.y ; y <= bottomRight.y ; ++y)
+	for (int16_t x = topLeft.x ; x <= bottomRight.x ; ++x)
+		if (Search.Reached(y * width + x))
+		{
+			const int d = Search.Distance(y * width + x);
+			if (d >= DistanceField::unreached) return DistanceField();	// too far for 16 bits: this landmark won't be used
+			Field.Set(TileCoord(x, y), d);
+		}
+
+	return Field;
+}
+
+
+// Updates Field after the Tiles in NewTiles became walkable (a blocking Neutral was destroyed).
+// The distances can only decrease, so Dijkstra's algorithm is run from the new Tiles, reached from their neighbours,
+// and only the Tiles whose distance decreases are visited. This is usually a small part of the Map, unlike ComputeGroundDistanceField.
+// The result is the same as ComputeGroundDistanceField(Field.Origin()), except that the rectangle of Field can only grow.
+void Graph::UpdateGroundDistanceField(DistanceField & Field, const vector<TileCoord> & NewTiles) const
+{
+	const Map * pMap = GetMap();
+	const int width = static_cast<int>(pMap->Size().x);
+	const int height = static_cast<int>(pMap->Size().y);
+
+	static thread_local ShortestPathSearch<TileCoord> Search;
+	Search.Begin(width * height);
+
+	// Offers dist to next, unless the distance already known is not greater.
+	const auto relax = [&Field](int n, TileCoord next, int dist)
+	{
+		const int known = Field.Distance(next);
+		if ((known == -1) || (dist < known)) Search.Relax(n, next, dist);
+	};
+
+	// 1) Reach the new Tiles from their neighbours:
+	for (const TileCoord & t : NewTiles)
+		if (groundWalkable(pMap->Tiles()[t.y * width + t.x]))
+			for (int dy = -1 ; dy <= +1 ; ++dy)
+			for (int dx = -1 ; dx <= +1 ; ++dx)
+			{
+				const TileCoord neighbour(int16_t(t.x + dx), int16_t(t.y + dy));
+				if ((dx == 0 && dy == 0) || (neighbour.x < 0) || (neighbour.y < 0) || (neighbour.x >= width) || (neighbour.y >= height)) continue;
+
+				const int d = Field.Distance(neighbour);
+				if (d != -1) relax(t.y * width + t.x, t, d + ((dx && dy) ? diagonal_move : orthogonal_move));
+			}
+
+	// 2) Propagate the decreases:
+	vector<pair<TileCoord, int>> Decreased;
+	TileCoord topLeft = Field.TopLeft();
+	TileCoord bottomRight(int16_t(topLeft.x + Field.Width() - 1), int16_t(topLeft.y + Field.Height() - 1));
+	while (!Search.Empty())
+	{
+		const int c = Search.Pop();
+		const TileCoord current = Search.Node(c);
+		const int currentDist = Search.Distance(c);
+		if (currentDist > DistanceField::max_distance) { Field = DistanceField(); return; }	// too far for 16 bits: this landmark won't be used
+		Decreased.emplace_back(current, currentDist);
+		makeBoundingBoxIncludePoint(topLeft, bottomRight, current);
+
+		for (int dy = -1 ; dy <= +1 ; ++dy)
+		for (int dx = -1 ; dx <= +1 ; ++dx)
+		{
+			const TileCoord next(int16_t(current.x + dx), int16_t(current.y + dy));
+			if ((dx == 0 && dy == 0) || (next.x < 0) || (next.y < 0) || (next.x >= width) || (next.y >= height)) continue;
+
+			const int n = next.y * width + next.x;
+			if (Search.Reached(n) || groundWalkable(pMap->Tiles()[n]))
+				relax(n, next, currentDist + ((dx && dy) ? diagonal_move : orthogonal_move));
+		}
+	}
+
+	if (Decreased.empty()) return;
+
+	// 3) Grow the rectangle of Field if some Tiles are reached for the first time outside of it, then apply the decreases.
+	if ((topLeft != Field.TopLeft()) || (bottomRight.x - topLeft.x + 1 != Field.Width()) || (bottomRight.y - topLeft.y + 1 != Field.Height()))
+	{
+		DistanceField Larger(Field.Origin(), topLeft, bottomRight.x - topLeft.x + 1, bottomRight.y - topLeft.y + 1);
+		for (int16_t y = Field.TopLeft().y ; y < Field.TopLeft().y + Field.Height() ; ++y)
+		for (int16_t x = Field.TopLeft().x ; x < Field.TopLeft().x + Field.Width() ; ++x)
+		{
+			const int d = Field.Distance(TileCoord(x, y));
+			if (d != -1) Larger.Set(TileCoord(x, y), d);
+		}
+		Field = move(Larger);
+	}
+
+	for (const auto & t : Decreased)
+		Field.Set(t.first, t.second);
+}
+
+
+// Cf. UpdateGroundDistanceField. The landmarks keep their origins.
+void Graph::UpdateLandmarks(const vector<TileCoord> & NewTiles)
+{
+	for (DistanceField & Landmark : m_Landmarks)
+		if (Landmark.Width() > 0)		// else it was too far for 16 bits (Cf. ComputeGroundDistanceField)
+			UpdateGroundDistanceField(Landmark, NewTiles);
+}
+
+
+// The landmarks are the starting locations, then the Bases farthest from the landmarks already chosen, up to max_landmarks.
+// Landmarks spread around the Map give good lower bounds for most of the queries of GetGroundDistance.
+void Graph::ComputeLandmarks()
+{
+	const Map * pMap = GetMap();
+
+	vector<TileCoord> Origins;
+	for (const TilePosition & t : pMap->StartingLocations())
+		if ((int)Origins.size() < max_landmarks)
+		{
+			const TileCoord origin = NearestWalkableTile(t);
+			if (!contains(Origins, origin)) Origins.push_back(origin);
+		}
+
+	vector<TileCoord> Candidates;
+	for (const Area & area : Areas())
+		for (const Base & base : area.Bases())
+			Candidates.push_back(NearestWalkableTile(base.Location()));
+
+	while (((int)Origins.size() < max_landmarks) && !Candidates.empty())
+	{
+		int bestDist = -1;
+		auto best = Candidates.begin();
+		for (auto it = Candidates.begin() ; it != Candidates.end() ; ++it)
+		{
+			int minDist = numeric_limits<int>::max();
+			for (const TileCoord & origin : Origins)
+				minDist = min(minDist, squaredDist(*it, origin));
+
+			if (minDist > bestDist)
+			{
+				bestDist = minDist;
+				best = it;
+			}
+		}
+
+		if (bestDist == 0) break;		// all the remaining Candidates are landmarks already
+		Origins.push_back(*best);
+		Candidates.erase(best);
+	}
+
+	m_Landmarks.assign(Origins.size(), DistanceField());
+	parallel_for(0, int(Origins.size()), [this, &Origins](int i)
+	{
+		m_Landmarks[i] = ComputeGroundDistanceField(Origins[i]);
+	});
 }
 
 
@@ -472,10 +1260,11 @@ void Graph::UpdateGroupIds()
 {
 	Area::groupId nextGroupId = 1;
 
-	Area::UnmarkAll();
+	vector<bool> Visited(AreasCount() + 1, false);		// index == Area::id
 	for (Area & start : Areas())
-		if (!start.Marked())
+		if (!Visited[start.Id()])
 		{
+			Visited[start.Id()] = true;
 			vector<Area *> ToVisit{&start};
 			while (!ToVisit.empty())
 			{
@@ -484,9 +1273,9 @@ void Graph::UpdateGroupIds()
 				current->SetGroupId(nextGroupId);
 
 				for (const Area * next : current->AccessibleNeighbours())
-					if (!next->Marked())
+					if (!Visited[next->Id()])
 					{
-						next->SetMarked();
+						Visited[next->Id()] = true;
 						ToVisit.push_back(const_cast<Area *>(next));
 					}
 			}
@@ -524,12 +1313,246 @@ void Graph::CollectInformation()
 
 void Graph::CreateBases()
 {
+	// Each Area only reads the Map and creates its own Bases (Cf. Area::CreateBases):
+	parallel_for(0, AreasCount(), [this](int i) { m_Areas[i].CreateBases(); });
+
+	m_baseCount = 0;
+	for (const Area & area : m_Areas)
+		m_baseCount += static_cast<int>(area.Bases().size());
+}
+
+
+
+static void writeDistanceField(CacheWriter & out, const DistanceField & Field)
+{
+	out.Write(Field.Origin());
+	out.Write(Field.TopLeft());
+	out.Write(int32_t(Field.Width()));
+	out.Write(int32_t(Field.Height()));
+	out.WriteBytes(Field.Raw().data(), Field.Raw().size() * sizeof(uint16_t));
+}
+
+
+static DistanceField readDistanceField(CacheReader & in, const Map * pMap)
+{
+	const TileCoord origin = in.ReadPosition<TileCoord>();
+	const TileCoord topLeft = in.ReadPosition<TileCoord>();
+	const int width = in.ReadCount(static_cast<int>(pMap->Size().x));
+	const int height = in.ReadCount(static_cast<int>(pMap->Size().y));
+	if (width && height &&
+		(!pMap->Valid(TilePosition(origin)) || !pMap->Valid(TilePosition(topLeft)) ||
+		 !pMap->Valid(TilePosition(topLeft) + TilePosition(float(width - 1), float(height - 1)))))
+		throw Exception("analysis cache: invalid distance field");
+
+	DistanceField Field(origin, topLeft, width, height);
+	memcpy(Field.Raw().data(), in.ReadBytes(Field.Raw().size() * sizeof(uint16_t)), Field.Raw().size() * sizeof(uint16_t));
+	return Field;
+}
+
+
+void Graph::SaveCache(CacheWriter & out, const map<const Neutral *, int> & NeutralIndex) const
+{
+	auto neutralIndex = [&NeutralIndex](const Neutral * n) { return n ? NeutralIndex.at(n) : -1; };
+
+	// 1) Areas:
+	out.Write(int32_t(AreasCount()));
+	for (const Area & area : Areas())
+	{
+		out.Write(area.Top());
+		out.Write(int32_t(area.MiniTiles()));
+	}
+
+	// 2) ChokePoints, in the order of m_ChokePointList:
+	out.Write(int32_t(m_ChokePointList.size()));
+	for (const ChokePoint * cp : ChokePoints())
+	{
+		out.Write(int32_t(cp->Index()));
+		out.Write(cp->GetAreas().first->Id());
+		out.Write(cp->GetAreas().second->Id());
+		out.Write(int32_t(neutralIndex(cp->BlockingNeutral())));
+
+		out.Write(int32_t(cp->Geometry().size()));
+		for (WalkCoord w : cp->Geometry())
+			out.Write(w);
+
+		for (int n = 0 ; n < ChokePoint::node_count ; ++n)
+		{
+			out.Write(cp->Pos(ChokePoint::node(n)));
+			out.Write(cp->PosInArea(ChokePoint::node(n), cp->GetAreas().first));
+			out.Write(cp->PosInArea(ChokePoint::node(n), cp->GetAreas().second));
+		}
+	}
+
+	// 3) Distances and next hops between ChokePoints:
+	for (int d : m_ChokePointDistanceMatrix)
+		out.Write(int32_t(d));
+
+	for (CPPathView::hop h : m_ChokePointNextHops)
+		out.Write(h);
+
+	// 4) Distance fields of the ChokePoints in each Area (in the order of Area::ChokePoints()):
+	for (const Area & area : Areas())
+		for (const ChokePoint * cp : area.ChokePoints())
+			writeDistanceField(out, area.ChokePointDistanceField(cp));
+
+	// 5) Bases:
+	for (const Area & area : Areas())
+	{
+		out.Write(int32_t(area.Bases().size()));
+		for (const Base & base : area.Bases())
+		{
+			out.Write(base.Location());
+
+			out.Write(int32_t(base.Minerals().size() + base.Geysers().size()));
+			for (const Mineral * m : base.Minerals())	out.Write(int32_t(neutralIndex(m)));
+			for (const Geyser * g : base.Geysers())		out.Write(int32_t(neutralIndex(g)));
+
+			out.Write(int32_t(base.BlockingMinerals().size()));
+			for (const Mineral * m : base.BlockingMinerals())	out.Write(int32_t(neutralIndex(m)));
+		}
+	}
+
+	// 6) Landmarks:
+	out.Write(int32_t(m_Landmarks.size()));
+	for (const DistanceField & Landmark : m_Landmarks)
+		writeDistanceField(out, Landmark);
+}
+
+
+void Graph::LoadCache(CacheReader & in, const vector<Neutral *> & Neutrals)
+{
+	const int maxIndex = (int)Neutrals.size() - 1;
+	const int walkSize = GetMap()->WalkSize().x * GetMap()->WalkSize().y;
+
+	// 1) Areas:
+	vector<pair<WalkPosition, int>> AreasList(in.ReadCount(walkSize));
+	for (auto & a : AreasList)
+	{
+		a.first = in.ReadPosition<WalkPosition>();
+		a.second = in.Read<int32_t>();
+	}
+	CreateAreas(AreasList);
+
+	auto readArea = [this, &in]() -> Area *
+	{
+		const Area::id id = in.Read<Area::id>();
+		if (!Valid(id)) throw Exception("analysis cache: invalid Area id");
+		return GetArea(id);
+	};
+
+	// 2) ChokePoints: because ChokePoint is not copyable, each vector of the matrix is reserved exactly before emplacing.
+	struct ChokePointRecord
+	{
+		ChokePoint::index			index;
+		Area *						pA;
+		Area *						pB;
+		Neutral *					pBlockingNeutral;
+		deque<WalkCoord>			Geometry;
+		WalkPosition				nodes[ChokePoint::node_count];
+		pair<WalkPosition, WalkPosition> nodesInArea[ChokePoint::node_count];
+	};
+
+	vector<ChokePointRecord> Records(in.ReadCount(walkSize));
+	vector<bool> IndexUsed(Records.size(), false);
+	for (auto & r : Records)
+	{
+		r.index = in.ReadCount((int)Records.size() - 1);
+		if (IndexUsed[r.index]) throw Exception("analysis cache: duplicate ChokePoint index");
+		IndexUsed[r.index] = true;
+		r.pA = readArea();
+		r.pB = readArea();
+		const int blockingIndex = in.Read<int32_t>();
+		if ((blockingIndex < -1) || (blockingIndex > maxIndex)) throw Exception("analysis cache: invalid Neutral index");
+		r.pBlockingNeutral = (blockingIndex == -1) ? nullptr : Neutrals[blockingIndex];
+
+		r.Geometry.resize(in.ReadCount(walkSize));
+		if (r.Geometry.empty()) throw Exception("analysis cache: empty ChokePoint");
+		for (WalkCoord & w : r.Geometry)
+			w = in.ReadPosition<WalkCoord>();
+
+		for (int n = 0 ; n < ChokePoint::node_count ; ++n)
+		{
+			r.nodes[n] = in.ReadPosition<WalkPosition>();
+			r.nodesInArea[n].first = in.ReadPosition<WalkPosition>();
+			r.nodesInArea[n].second = in.ReadPosition<WalkPosition>();
+		}
+	}
+
+	m_ChokePointsMatrix.resize(AreasCount() + 1);
+	for (Area::id id = 1 ; id <= AreasCount() ; ++id)
+		m_ChokePointsMatrix[id].resize(id);			// triangular matrix
+
+	map<pair<Area::id, Area::id>, int> ChokePointsByAreaPair;
+	for (const auto & r : Records)
+		++ChokePointsByAreaPair[make_pair(min(r.pA->Id(), r.pB->Id()), max(r.pA->Id(), r.pB->Id()))];
+
+	for (const auto & it : ChokePointsByAreaPair)
+		GetChokePoints(it.first.first, it.first.second).reserve(it.second);
+
+	for (const auto & r : Records)
+		GetChokePoints(r.pA, r.pB).emplace_back(this, r.index, r.pA, r.pB, r.Geometry, r.pBlockingNeutral, r.nodes, r.nodesInArea);
+
+	RegisterChokePoints();
+
+	// 3) Distances and next hops between ChokePoints:
+	m_ChokePointDistanceMatrix.resize(ChokePointCount() * ChokePointCount());
+	for (int & d : m_ChokePointDistanceMatrix)
+		d = in.Read<int32_t>();
+
+	m_ChokePointNextHops.resize(ChokePointCount() * ChokePointCount());
+	for (CPPathView::hop & h : m_ChokePointNextHops)
+	{
+		h = in.Read<CPPathView::hop>();
+		if ((h < CPPathView::none) || (h >= ChokePointCount())) throw Exception("analysis cache: invalid ChokePoint index");
+	}
+	m_chokePointDistanceMatrixStale = false;
+
+	for (Area & area : Areas())
+		area.UpdateAccessibleNeighbours();
+
+	UpdateGroupIds();
+
+	// 4) Distance fields of the ChokePoints in each Area:
+	for (Area & area : m_Areas)
+	{
+		area.ChokePointDistanceFields().clear();
+		for (size_t n = 0 ; n < area.ChokePoints().size() ; ++n)
+			area.ChokePointDistanceFields().push_back(readDistanceField(in, GetMap()));
+	}
+
+	// 5) Areas' information (cheap to recompute):
+	CollectInformation();
+
+	// 6) Bases:
+	auto readNeutral = [&in, &Neutrals, maxIndex]() { return Neutrals[in.ReadCount(maxIndex)]; };
+
 	m_baseCount = 0;
 	for (Area & area : m_Areas)
 	{
-		area.CreateBases();
+		const int bases = in.ReadCount(maxIndex + 1);
+		area.Bases().reserve(bases);
+		for (int n = 0 ; n < bases ; ++n)
+		{
+			const TilePosition location = in.ReadPosition<TilePosition>();
+
+			vector<Ressource *> AssignedRessources(in.ReadCount(maxIndex + 1));
+			for (Ressource *& r : AssignedRessources)
+				if (!(r = readNeutral()->IsRessource())) throw Exception("analysis cache: invalid Ressource");
+			if (AssignedRessources.empty()) throw Exception("analysis cache: Base without Ressource");
+
+			vector<Mineral *> BlockingMinerals(in.ReadCount(maxIndex + 1));
+			for (Mineral *& m : BlockingMinerals)
+				if (!(m = readNeutral()->IsMineral())) throw Exception("analysis cache: invalid Mineral");
+
+			area.Bases().emplace_back(&area, location, AssignedRessources, BlockingMinerals);
+		}
 		m_baseCount += static_cast<int>(area.Bases().size());
 	}
+
+	// 7) Landmarks:
+	m_Landmarks.resize(in.ReadCount(max_landmarks));
+	for (DistanceField & Landmark : m_Landmarks)
+		Landmark = readDistanceField(in, GetMap());
 }
 
 	
@@ -16,6 +16,8 @@
 #include "cp.h"
 #include "area.h"
 #include "bwapiExt.h"
+#include "shortestPaths.h"
+#include "tilePath.h"
 #include "utils.h"
 #include "defs.h"
 
@@ -31,6 +33,8 @@ namespace SC2EM {
 	namespace detail {
 
 		class MapImpl;
+		class CacheWriter;
+		class CacheReader;
 
 		using namespace std;
 		using namespace utils;
@@ -89,12 +93,27 @@ namespace SC2EM {
 			const vector<ChokePoint> &			GetChokePoints(const Area * a, const Area * b) const { return GetChokePoints(a->Id(), b->Id()); }
 
 			// Returns the ground distance in pixels between cpA->Center() and cpB>Center()
-			int									Distance(const ChokePoint * cpA, const ChokePoint * cpB) const { return m_ChokePointDistanceMatrix[cpA->Index()][cpB->Index()]; }
+			int									Distance(const ChokePoint * cpA, const ChokePoint * cpB) const { return m_ChokePointDistanceMatrix[MatrixIndex(cpA, cpB)]; }
 
 			// Returns a list of ChokePoints, which is intended to be the shortest walking path from cpA to cpB.
-			const CPPath &						GetPath(const ChokePoint * cpA, const ChokePoint * cpB) const { return m_PathsBetweenChokePoints[cpA->Index()][cpB->Index()]; }
+			CPPath								GetPath(const ChokePoint * cpA, const ChokePoint * cpB) const
+												{ return CPPath(m_ChokePointsByIndex.data(), m_ChokePointNextHops.data(), ChokePointCount(), cpA->Index(), cpB->Index()); }
 
-			const CPPath &						GetPath(const Sc2Bindings::Position & a, const Sc2Bindings::Position & b, int * pLength = nullptr) const;
+			CPPath								GetPath(const Sc2Bindings::Position & a, const Sc2Bindings::Position & b, int * pLength = nullptr) const;
+
+			// Cf. Map::GetPaths
+			void								GetPaths(utils::Span<const Sc2Bindings::Position> From, utils::Span<const Sc2Bindings::Position> To,
+														utils::Span<CPPath> Paths, utils::Span<int> Lengths) const;
+
+			// Cf. Map::GetGroundDistance
+			int									GetGroundDistance(const Sc2Bindings::Position & a, const Sc2Bindings::Position & b) const;
+
+			// Cf. Map::GetTilePath
+			int									GetTilePath(const Sc2Bindings::Position & a, const Sc2Bindings::Position & b, TilePath & Path) const;
+
+			// The distance fields of the landmarks used by GetGroundDistance: each one holds the ground distances
+			// from all the Tiles to some Tile, chosen among the starting locations and the Bases (Cf. ComputeLandmarks).
+			const vector<DistanceField> &		Landmarks() const { return m_Landmarks; }
 
 			int									BaseCount() const { return m_baseCount; }
 
@@ -110,26 +129,79 @@ namespace SC2EM {
 
 			void								ComputeChokePointDistanceMatrix();
 
+			// Updates the distances and paths between the ChokePoints after a blocking Neutral was destroyed,
+			// which changed the Tiles in ChangedTiles and unblocked the ChokePoints in UnblockedChokePoints.
+			void								UpdateChokePointDistanceMatrix(const vector<Sc2Bindings::TileCoord> & ChangedTiles, const vector<const ChokePoint *> & UnblockedChokePoints);
+
+			// Records that some Tiles have changed while the paths were not updated (Cf. Map::AutomaticPathUpdate()),
+			// so that the next UpdateChokePointDistanceMatrix recomputes all the distances and paths.
+			void								InvalidateChokePointDistanceMatrix() { m_chokePointDistanceMatrixStale = true; }
+
 			void								CollectInformation();
 			void								CreateBases();
 
+			// Chooses the landmarks and computes their distance fields.
+			void								ComputeLandmarks();
+			void								ClearLandmarks() { m_Landmarks.clear(); }
+
+			// Updates the distance fields of the landmarks after the Tiles in NewTiles became walkable (Cf. UpdateGroundDistanceField).
+			void								UpdateLandmarks(const vector<Sc2Bindings::TileCoord> & NewTiles);
+
+			// Writes / restores the result of CreateAreas .. CreateBases (Cf. MapImpl::SaveCache and MapImpl::LoadCache).
+			// Neutrals are identified by their index in the canonical order of the neutrals.
+			void								SaveCache(CacheWriter & out, const map<const Neutral *, int> & NeutralIndex) const;
+			void								LoadCache(CacheReader & in, const vector<Neutral *> & Neutrals);
+
 		private:
+			// The distances and paths from pStart to the ChokePoints preceding it in its Context (Cf. ComputeChokePointDistances).
+			// Each path is given by its second and its second to last ChokePoints (Cf. SetPath).
+			struct DistancesFrom
+			{
+				const ChokePoint *				pStart;
+				vector<const ChokePoint *>		Targets;
+				vector<int>						Distances;
+				vector<const ChokePoint *>		FirstHops;
+				vector<const ChokePoint *>		LastHops;
+			};
+
 			template<class Context>
 			void								ComputeChokePointDistances(const Context * pContext);
-			vector<int>							ComputeDistances(const ChokePoint * pStartCP, const vector<const ChokePoint *> & TargetCPs) const;
+			template<class Context>
+			DistancesFrom						ComputeDistancesFrom(const Context * pContext, const ChokePoint * pStart) const;
+			void								SetDistancesFrom(const DistancesFrom & Result);
+			vector<int>							IntraAreaDistances(const Area & area) const;
+			void								RelaxThroughEdge(const ChokePoint * cpU, const ChokePoint * cpV, int distUV);
+			void								RelaxThrough(const ChokePoint * pivot);
+			void								Improve(const ChokePoint * cpA, const ChokePoint * cpB, int dist, const ChokePoint * afterA, const ChokePoint * beforeB);
+			vector<int>							ComputeDistances(const Area * pArea, const ChokePoint * pStartCP, const vector<const ChokePoint *> & TargetCPs,
+																	vector<const ChokePoint *> & FirstHops, vector<const ChokePoint *> & LastHops) const;
+			vector<int>							ComputeDistances(const Graph * pGraph, const ChokePoint * pStartCP, const vector<const ChokePoint *> & TargetCPs,
+																	vector<const ChokePoint *> & FirstHops, vector<const ChokePoint *> & LastHops) const;
 			void								SetDistance(const ChokePoint * cpA, const ChokePoint * cpB, int value);
+			void								RegisterChokePoints();
 			void								UpdateGroupIds();
-			void								SetPath(const ChokePoint * cpA, const ChokePoint * cpB, const CPPath & PathAB);
+			void								SetPath(const ChokePoint * cpA, const ChokePoint * cpB, const ChokePoint * afterA, const ChokePoint * beforeB);
+			const ChokePoint *					NextHop(const ChokePoint * cpA, const ChokePoint * cpB) const	{ return m_ChokePointsByIndex[m_ChokePointNextHops[MatrixIndex(cpA, cpB)]]; }
+			int									ChokePointCount() const											{ return int(m_ChokePointsByIndex.size()); }
+			int									MatrixIndex(const ChokePoint * cpA, const ChokePoint * cpB) const { return cpA->Index() * ChokePointCount() + cpB->Index(); }
 			bool								Valid(Area::id id) const { return (1 <= id) && (id <= AreasCount()); }
+			DistanceField						ComputeGroundDistanceField(Sc2Bindings::TileCoord origin) const;
+			void								UpdateGroundDistanceField(DistanceField & Field, const vector<Sc2Bindings::TileCoord> & NewTiles) const;
+			Sc2Bindings::TileCoord				NearestWalkableTile(const Sc2Bindings::TilePosition & t) const;
+			int									SearchTilePath(Sc2Bindings::TileCoord start, Sc2Bindings::TileCoord target, TilePath * pPath) const;
+			bool								RefineTilePath(Sc2Bindings::TileCoord start, const Area * pAreaA, Sc2Bindings::TileCoord target, const Area * pAreaB, TilePath & Path) const;
+			bool								DescendDistanceField(const DistanceField & Field, TilePath & Path) const;
 
 			MapImpl * const						m_pMap;
 			vector<Area>						m_Areas;
 			vector<ChokePoint *>				m_ChokePointList;
 			vector<vector<vector<ChokePoint>>>	m_ChokePointsMatrix;			// index == Area::id x Area::id
-			vector<vector<int>>					m_ChokePointDistanceMatrix;		// index == ChokePoint::index x ChokePoint::index
-			vector<vector<CPPath>>				m_PathsBetweenChokePoints;		// index == ChokePoint::index x ChokePoint::index
-			const CPPath						m_EmptyPath;
+			vector<const ChokePoint *>			m_ChokePointsByIndex;			// index == ChokePoint::index
+			vector<int>							m_ChokePointDistanceMatrix;		// index == MatrixIndex(cpA, cpB)
+			vector<CPPathView::hop>				m_ChokePointNextHops;			// index == MatrixIndex(cpA, cpB): the ChokePoint following cpA on GetPath(cpA, cpB)
+			bool								m_chokePointDistanceMatrixStale = false;
 			int									m_baseCount;
+			vector<DistanceField>				m_Landmarks;
 		};
 
 
@@ -0,0 +1,95 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is part of the BWEM Library.
+// BWEM is free software, licensed under the MIT/X11 License.
+// A copy of the license is provided with the library in the LICENSE file.
+// Copyright (c) 2015, 2017, Igor Dimitrijevic
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef BWEM_INTEGRAL_GRID_H
+#define BWEM_INTEGRAL_GRID_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "defs.h"
+
+
+namespace SC2EM {
+namespace utils {
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class IntegralGrid
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+//
+// A summed-area table (integral image) over the width x height rectangle of some grid starting at (Left(), Top()).
+// Once built, Sum returns the sum of the values of the cells of any rectangle in O(1),
+// whatever its size, which makes footprint checks (buildability, Neutrals, ...) constant time.
+// Entry (x, y) of the table is the sum over the cells of [Left(), Left() + x) x [Top(), Top() + y).
+//
+
+class IntegralGrid
+{
+public:
+								IntegralGrid() = default;
+
+	int							Left() const				{ return m_left; }
+	int							Top() const					{ return m_top; }
+	int							Width() const				{ return m_width; }
+	int							Height() const				{ return m_height; }
+
+	// Builds the table. value(x, y) must return the value of the cell (x, y), in the coordinates of the whole grid.
+	template<class F>
+	void						Build(int left, int top, int width, int height, F value)
+	{
+		bwem_assert((width >= 0) && (height >= 0));
+		m_left = left;
+		m_top = top;
+		m_width = width;
+		m_height = height;
+
+		const int w = width + 1;
+		m_Sums.assign(size_t(w) * (height + 1), 0);
+		for (int y = 0 ; y < height ; ++y)
+		{
+			int32_t rowSum = 0;
+			for (int x = 0 ; x < width ; ++x)
+			{
+				rowSum += value(left + x, top + y);
+				const size_t i = size_t(y + 1) * w + x + 1;
+				m_Sums[i] = m_Sums[i - w] + rowSum;
+			}
+		}
+	}
+
+	// Returns the sum of the values of the cells of [x, x + width) x [y, y + height), clipped to the table.
+	int							Sum(int x, int y, int width, int height) const
+	{
+		const int x1 = std::max(x - m_left, 0);
+		const int y1 = std::max(y - m_top, 0);
+		const int x2 = std::min(x - m_left + width, m_width);
+		const int y2 = std::min(y - m_top + height, m_height);
+		if ((x1 >= x2) || (y1 >= y2)) return 0;
+
+		const size_t w = m_width + 1;
+		return m_Sums[y2 * w + x2] - m_Sums[y1 * w + x2] - m_Sums[y2 * w + x1] + m_Sums[y1 * w + x1];
+	}
+
+private:
+	int							m_left = 0;
+	int							m_top = 0;
+	int							m_width = 0;
+	int							m_height = 0;
+	std::vector<int32_t>		m_Sums;				// index == y * (m_width + 1) + x
+};
+
+
+}} // namespace SC2EM::utils
+
+
+#endif
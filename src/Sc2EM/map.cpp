@@ -72,6 +72,16 @@ Position Map::RandomPosition() const
 }
 
 
+bool Map::CanBuild(TileCoord topLeft, TileCoord size, const Area * pArea) const
+{
+	if ((topLeft.x < 0) || (topLeft.y < 0) || (topLeft.x + size.x > Size().x) || (topLeft.y + size.y > Size().y)) return false;
+
+	const int tiles = size.x * size.y;
+	return (BuildableTileCount(topLeft, size) == tiles) && (NeutralTileCount(topLeft, size) == 0) &&
+			(!pArea || (AreaTileCount(pArea, topLeft, size) == tiles));
+}
+
+
 template<class TPosition>
 TPosition crop(const TPosition & p, float siseX, float sizeY)
 {
@@ -116,9 +126,9 @@ const MiniTile &Map::GetMiniTile(const Sc2Bindings::WalkPosition & p, utils::che
 	bwem_assert((checkMode == utils::check_t::no_check) || Valid(p)); 
 	utils::unused(checkMode); 
 	int index = static_cast<int>(WalkSize().x * p.y + p.x);
-	if (index >= m_Tiles.size())
+	if (index >= m_MiniTiles.size())
 	{
-		index = m_Tiles.size() - 1;
+		index = m_MiniTiles.size() - 1;
 	}
 	return m_MiniTiles[index];
 }
@@ -18,6 +18,11 @@
 #include "tiles.h"
 #include "area.h"
 #include "cp.h"
+#include "tilePath.h"
+#include "mapStats.h"
+#include "bitGrid.h"
+#include "integralGrid.h"
+#include "visitedGrid.h"
 #include "utils.h"
 #include "defs.h"
 
@@ -32,6 +37,7 @@ namespace SC2EM
 	class Geyser;
 	class StaticBuilding;
 	class ChokePoint;
+	class MapSource;
 
 
 	//////////////////////////////////////////////////////////////////////////////////////////////
@@ -64,6 +70,28 @@ namespace SC2EM
 		// A good place to do this is in ExampleAIModule::onStart()
 		virtual void						Initialize(const ObservationInterface *obs) = 0;
 
+		// Same as above, but the terrain information is read from any MapSource (Cf. mapSource.h).
+		// For example, Initialize(SnapshotMapSource("map.snapshot")) runs the whole analysis without any game client.
+		virtual void						Initialize(const MapSource & source) = 0;
+
+		// Same as above, except that the results of the analysis are read from the file cacheFileName,
+		// provided this file was written for the same terrain (the cache is keyed by a hash of the raw pathing, placement
+		// and height grids, starting locations and neutrals of the map, so a cache file for another map is rejected at once).
+		// Otherwise, the analysis is computed as usual and then written to cacheFileName, so that the next games
+		// on the same map can skip it. A missing, outdated or corrupted cache file is simply recomputed.
+		virtual void						Initialize(const MapSource & source, const std::string & cacheFileName) = 0;
+
+		// Caps the number of threads Initialize may use for its independent tasks (Cf. utils::parallel_for).
+		// 0, the default, means one per hardware thread. 1 makes Initialize run entirely in the calling thread.
+		static void							SetMaxThreads(int n) { utils::SetMaxThreads(n); }
+
+		// Tells whether the last call to Initialize could read the results of the analysis from a cache file.
+		virtual bool						InitializedFromCache() const = 0;
+
+		// Returns the time spent in each stage of the last call to Initialize (and, if enabled, the allocations made).
+		// Use GetInitializationStats().ToJson() to log them.
+		virtual const InitializationStats &	GetInitializationStats() const = 0;
+
 		// Will return true once Initialize() has been called.
 		bool								Initialized() const { return m_size != 0; }
 
@@ -115,21 +143,62 @@ namespace SC2EM
 		// Returns a MiniTile, given its position.
 		const MiniTile &					GetMiniTile(const Sc2Bindings::WalkPosition & p, utils::check_t checkMode = utils::check_t::check) const;
 
+		// Same as above, but with integer arithmetic only.
+		const MiniTile &					GetMiniTile(const Sc2Bindings::WalkCoord & p, utils::check_t checkMode = utils::check_t::check) const
+												{ bwem_assert((checkMode == utils::check_t::no_check) || Valid(p)); utils::unused(checkMode); return m_MiniTiles[p.y * m_walkWidth + p.x]; }
+
 		// Returns a Tile or a MiniTile, given its position.
 		// Provided as a support of generic algorithms.
 		template<class TPosition>
 		const typename utils::TileOfPosition<TPosition>::type & GetTTile(const TPosition & p, utils::check_t checkMode = utils::check_t::check) const;
 
 		// Provides access to the internal array of Tiles.
+		// The Tile at (x, y) is Tiles()[y * Size().x + x].
 		const std::vector<Tile> &			Tiles() const { return m_Tiles; }
 
+		// Same as Tiles(), as a view: TilesView().subspan(y * Size().x, Size().x) is the row y.
+		utils::Span<const Tile>				TilesView() const { return utils::Span<const Tile>(m_Tiles.data(), m_Tiles.size()); }
+
 		// Provides access to the internal array of MiniTiles.
+		// The MiniTile at (x, y) is MiniTiles()[y * WalkSize().x + x].
 		const std::vector<MiniTile> &		MiniTiles() const { return m_MiniTiles; }
 
+		// Same as MiniTiles(), as a view: MiniTilesView().subspan(y * WalkSize().x, WalkSize().x) is the row y.
+		utils::Span<const MiniTile>			MiniTilesView() const { return utils::Span<const MiniTile>(m_MiniTiles.data(), m_MiniTiles.size()); }
+
+		// Provides the walkability of all the MiniTiles, packed in a grid of bits:
+		// WalkabilityGrid().Get(x, y) == GetMiniTile(WalkPosition(x, y)).Walkable().
+		// Each row is made of 64-bit words, which allows the scans to process 64 MiniTiles at once.
+		const utils::BitGrid &				WalkabilityGrid() const { return m_WalkabilityGrid; }
+
+		// Rectangle queries, in O(1) whatever the size of the rectangle (Cf. utils::IntegralGrid).
+		// Each one counts the Tiles (or MiniTiles) of the rectangle [topLeft, topLeft + size) having some property.
+		// The rectangles are clipped to the Map.
+		// The counts are computed at the initialization, and the ones depending on the Neutrals are updated
+		// by OnMineralDestroyed and OnStaticBuildingDestroyed.
+
+		// Counts the buildable Tiles (Cf. Tile::Buildable()).
+		virtual int							BuildableTileCount(Sc2Bindings::TileCoord topLeft, Sc2Bindings::TileCoord size) const = 0;
+
+		// Counts the Tiles occupied by some Neutral (Cf. Tile::GetNeutral()).
+		virtual int							NeutralTileCount(Sc2Bindings::TileCoord topLeft, Sc2Bindings::TileCoord size) const = 0;
+
+		// Counts the Tiles of pArea (Cf. Tile::AreaId()).
+		virtual int							AreaTileCount(const Area * pArea, Sc2Bindings::TileCoord topLeft, Sc2Bindings::TileCoord size) const = 0;
+
+		// Counts the walkable MiniTiles (Cf. MiniTile::Walkable()).
+		virtual int							WalkableMiniTileCount(Sc2Bindings::WalkCoord topLeft, Sc2Bindings::WalkCoord size) const = 0;
+
+		// Returns true if the rectangle [topLeft, topLeft + size) is inside the Map, and all its Tiles are buildable,
+		// free of Neutrals and, if pArea != nullptr, belong to pArea.
+		// Typical use: checking the footprint of a building.
+		bool								CanBuild(Sc2Bindings::TileCoord topLeft, Sc2Bindings::TileCoord size, const Area * pArea = nullptr) const;
+
 		// Returns whether the position p is valid.
 		bool								Valid(const Sc2Bindings::TilePosition & p) const { return (0 <= p.x) && (p.x < Size().x) && (0 <= p.y) && (p.y < Size().y); }
 		bool								Valid(const Sc2Bindings::WalkPosition & p) const { return (0 <= p.x) && (p.x < WalkSize().x) && (0 <= p.y) && (p.y < WalkSize().y); }
 		bool								Valid(const Sc2Bindings::Position & p) const { return Valid(Sc2Bindings::WalkPosition(p)); }
+		bool								Valid(const Sc2Bindings::WalkCoord & p) const { return (0 <= p.x) && (p.x < m_walkWidth) && (0 <= p.y) && (p.y < m_walkHeight); }
 
 		// Returns the position closest to p that is valid.
 		Sc2Bindings::WalkPosition					Crop(const Sc2Bindings::WalkPosition & p) const;
@@ -201,16 +270,55 @@ namespace SC2EM
 		//       While this brings robustness, this could yield surprising results in the case where 'a' and/or 'b' are in the Water.
 		//       To avoid this and the potential performance penalty, just make sure GetArea(a) != nullptr and GetArea(b) != nullptr.
 		//       Then GetPath should perform very quick.
-		virtual const CPPath &				GetPath(const Sc2Bindings::Position & a, const Sc2Bindings::Position & b, int * pLength = nullptr) const = 0;
+		// Note: CPPath is a view of the precomputed paths, returned by value (Cf. CPPathView), no longer a const reference to a vector.
+		//       size() is O(1), but operator[](i) is O(i), so an indexed loop over a path is O(size()^2):
+		//       iterate it instead (for (const ChokePoint * cp : Path) ...), or copy it once with ToVector().
+		virtual CPPath						GetPath(const Sc2Bindings::Position & a, const Sc2Bindings::Position & b, int * pLength = nullptr) const = 0;
+
+		// Batch version of GetPath, for the many queries a bot typically makes at each frame:
+		// for each i, Paths[i] = GetPath(From[i], To[i], &Lengths[i]). The results are exactly the same as the ones of GetPath.
+		// From, To and Paths must have the same size. Lengths must have that size too, or be empty if the lengths are not needed.
+		// The queries are grouped by pair of Areas, so that the ChokePoints of each pair of Areas and the distances between them
+		// are gathered only once per group. The more queries share the same pairs of Areas, the cheaper they are.
+		// Can be called from several threads at the same time.
+		virtual void						GetPaths(utils::Span<const Sc2Bindings::Position> From, utils::Span<const Sc2Bindings::Position> To,
+													utils::Span<CPPath> Paths, utils::Span<int> Lengths = utils::Span<int>()) const = 0;
+
+		// Returns the ground distance in pixels between 'a' and 'b', or -1 if 'b' is not accessible from 'a'.
+		// Unlike the length given by GetPath, this distance is exact at the Tile level: it is the length of the shortest
+		// path between TilePosition(a) and TilePosition(b) made of 8-connected walkable Tiles (Tile::AreaId() != 0 and
+		// not blocked by a Neutral), where orthogonal moves cost 32 pixels and diagonal moves cost 45 pixels.
+		// 'a' and 'b' are first moved to the nearest walkable Tile if needed.
+		// Time complexity: the search is an A* guided by the distances to a few precomputed landmarks (ALT),
+		// so it usually visits only a small fraction of the Tiles. The Areas are used first to reject inaccessible pairs.
+		// Note: the landmarks are only updated when a blocking Neutral is destroyed if AutomaticPathUpdate() == true,
+		//       and then only around the Tiles it covered. Otherwise they are dropped: the distances remain exact, but the search becomes slower.
+		// Can be called from several threads at the same time.
+		virtual int							GetGroundDistance(const Sc2Bindings::Position & a, const Sc2Bindings::Position & b) const = 0;
+
+		// Fills Path with a near-shortest (hierarchical) walking path from 'a' to 'b' made of 8-connected walkable Tiles (Cf. GetGroundDistance),
+		// and returns its length in pixels, or -1 (and an empty Path) if 'b' is not accessible from 'a'.
+		// The first Tile of Path is the one of 'a' and the last one is the one of 'b' ('a' and 'b' being moved like in GetGroundDistance).
+		// Time complexity: if 'a' and 'b' are in different Areas, the search is hierarchical: the ChokePoints to go through
+		// are chosen using the distances precomputed in the Areas, and the Tiles inside each Area are just read from them.
+		// Only the crossings of the ChokePoints are actually searched. Otherwise, the search is the A* of GetGroundDistance.
+		// Note: the hierarchical path is shortest at the ChokePoint level, so that its length can slightly exceed GetGroundDistance(a, b).
+		// Path is cleared first, but keeps its memory: reusing the same TilePath avoids any allocation (Cf. class TilePath).
+		// Can be called from several threads at the same time, provided each one uses its own TilePath.
+		virtual int							GetTilePath(const Sc2Bindings::Position & a, const Sc2Bindings::Position & b, TilePath & Path) const = 0;
 
 		// Generic algorithm for breadth first search in the Map.
 		// See the several use cases in BWEM source files.
+		// Like the other const queries, it can be called from several threads at the same time.
 		template<class TPosition, class Pred1, class Pred2>
 		TPosition							BreadthFirstSearch(TPosition start, Pred1 findCond, Pred2 visitCond, bool connect8 = true) const;
 
 
 		// Returns the union of the geometry of all the ChokePoints. Cf. ChokePoint::Geometry()
-		virtual const std::vector<std::pair<std::pair<Area::id, Area::id>, Sc2Bindings::WalkPosition>> & RawFrontier() const = 0;
+		// Note: the positions are WalkCoords, no longer WalkPositions, which halves the size of the frontier.
+		//       This breaks the code that names the element type (pair<pair<Area::id, Area::id>, WalkPosition>),
+		//       while the code reading f.second as a WalkPosition still compiles (WalkCoord converts implicitly to WalkPosition).
+		virtual const std::vector<std::pair<std::pair<Area::id, Area::id>, Sc2Bindings::WalkCoord>> & RawFrontier() const = 0;
 
 		virtual								~Map() = default;
 
@@ -219,18 +327,30 @@ namespace SC2EM
 
 		Tile &								GetTile_(const Sc2Bindings::TilePosition & p, utils::check_t checkMode = utils::check_t::check);
 		MiniTile &							GetMiniTile_(const Sc2Bindings::WalkPosition & p, utils::check_t checkMode = utils::check_t::check);
+		MiniTile &							GetMiniTile_(const Sc2Bindings::WalkCoord & p, utils::check_t checkMode = utils::check_t::check)
+												{ return const_cast<MiniTile &>(GetMiniTile(p, checkMode)); }
 
 		float							m_size = 0;
 		Sc2Bindings::TilePosition			m_TileSize;
 
 		float							m_walkSize;
 		Sc2Bindings::WalkPosition			m_WalkSizePosition;
+		int								m_walkWidth = 0;		// WalkSize(), as integers
+		int								m_walkHeight = 0;
 
 		Sc2Bindings::Position				m_center;
 		std::vector<Tile>			m_Tiles;
 		std::vector<MiniTile>		m_MiniTiles;
+		utils::BitGrid				m_WalkabilityGrid;
 
 	private:
+		template<class TPosition>
+		const TPosition &					GridSize() const;
+
+		// Scratch of BreadthFirstSearch. There is one per thread, so that concurrent searches do not interfere.
+		template<class TPosition>
+		static utils::VisitedGrid<TPosition> &	SearchGrid()	{ static thread_local utils::VisitedGrid<TPosition> grid; return grid; }
+
 		static std::unique_ptr<Map>	m_gInstance;
 
 	};
@@ -249,17 +369,39 @@ namespace SC2EM
 	}
 
 
+	template<>
+	inline const Sc2Bindings::TilePosition & Map::GridSize<Sc2Bindings::TilePosition>() const
+	{
+		return Size();
+	}
+
+	template<>
+	inline const Sc2Bindings::WalkPosition & Map::GridSize<Sc2Bindings::WalkPosition>() const
+	{
+		return WalkSize();
+	}
+
 	template<class TPosition, class Pred1, class Pred2>
 	inline TPosition Map::BreadthFirstSearch(TPosition start, Pred1 findCond, Pred2 visitCond, bool connect8) const
 	{
 		typedef typename utils::TileOfPosition<TPosition>::type Tile_t;
 		if (findCond(GetTTile(start), start)) return start;
 
-		std::vector<TPosition> Visited;
-		std::queue<TPosition> ToVisit;
+		// The visited marks and the FIFO are reused from one search to the other.
+		// If the predicates themselves start a search, the nested one gets its own (allocated) VisitedGrid.
+		utils::VisitedGrid<TPosition> LocalGrid;
+		utils::VisitedGrid<TPosition> & Grid = SearchGrid<TPosition>().Busy() ? LocalGrid : SearchGrid<TPosition>();
+
+		// Positions may be fractional (start is not always integral), but all the positions visited are start + integral offsets,
+		// so their integral parts are enough to identify their cells.
+		const int width = static_cast<int>(GridSize<TPosition>().x);
+		const int height = static_cast<int>(GridSize<TPosition>().y);
+		const auto index = [width](const TPosition & p) { return static_cast<int>(p.y) * width + static_cast<int>(p.x); };
+
+		typename utils::VisitedGrid<TPosition>::Session session(Grid, width, height);
 
-		ToVisit.push(start);
-		Visited.push_back(start);
+		Grid.Push(start);
+		if (Valid(start)) Grid.SetVisited(index(start));
 
 		auto dir8 = { TPosition(-1, -1), TPosition(0, -1), TPosition(+1, -1),
 						TPosition(-1,  0),                   TPosition(+1,  0),
@@ -269,10 +411,9 @@ namespace SC2EM
 
 		auto directions = connect8 ? dir8 : dir4;
 
-		while (!ToVisit.empty())
+		while (!Grid.Empty())
 		{
-			TPosition current = ToVisit.front();
-			ToVisit.pop();
+			TPosition current = Grid.Pop();
 			for (TPosition delta : directions)
 			{
 				TPosition next = current + delta;
@@ -281,10 +422,11 @@ namespace SC2EM
 					const Tile_t & NextTile = GetTTile(next, utils::check_t::no_check);
 					if (findCond(NextTile, next)) return next;
 
-					if (visitCond(NextTile, next) && !utils::contains(Visited, next))
+					const int i = index(next);
+					if (!Grid.Visited(i) && visitCond(NextTile, next))
 					{
-						ToVisit.push(next);
-						Visited.push_back(next);
+						Grid.Push(next);
+						Grid.SetVisited(i);
 					}
 				}
 			}
@@ -0,0 +1,94 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is part of the BWEM Library.
+// BWEM is free software, licensed under the MIT/X11 License.
+// A copy of the license is provided with the library in the LICENSE file.
+// Copyright (c) 2015, 2017, Igor Dimitrijevic
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#include "mapCache.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+using namespace std;
+
+
+namespace SC2EM {
+namespace detail {
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class MappedFile
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const string & fileName)
+{
+	HANDLE hFile = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE) return;
+	m_hFile = hFile;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(hFile, &size) || (size.QuadPart == 0)) return;
+
+	HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!hMapping) return;
+	m_hMapping = hMapping;
+
+	m_pData = static_cast<const uint8_t *>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_pData) m_size = static_cast<size_t>(size.QuadPart);
+}
+
+
+MappedFile::~MappedFile()
+{
+	if (m_pData) UnmapViewOfFile(m_pData);
+	if (m_hMapping) CloseHandle(m_hMapping);
+	if (m_hFile) CloseHandle(m_hFile);
+}
+
+#else
+
+MappedFile::MappedFile(const string & fileName)
+{
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) return;
+
+	struct stat st;
+	if ((fstat(fd, &st) == 0) && (st.st_size > 0))
+	{
+		void * p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED)
+		{
+			m_pData = static_cast<const uint8_t *>(p);
+			m_size = static_cast<size_t>(st.st_size);
+		}
+	}
+
+	close(fd);		// the mapping remains valid
+}
+
+
+MappedFile::~MappedFile()
+{
+	if (m_pData) munmap(const_cast<uint8_t *>(m_pData), m_size);
+}
+
+#endif
+
+
+
+}} // namespace SC2EM::detail
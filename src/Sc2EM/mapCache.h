@@ -0,0 +1,143 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is part of the BWEM Library.
+// BWEM is free software, licensed under the MIT/X11 License.
+// A copy of the license is provided with the library in the LICENSE file.
+// Copyright (c) 2015, 2017, Igor Dimitrijevic
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef BWEM_MAP_CACHE_H
+#define BWEM_MAP_CACHE_H
+
+#include "Sc2Bindings.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <type_traits>
+#include "utils.h"
+#include "defs.h"
+
+
+namespace SC2EM {
+namespace detail {
+
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class MappedFile
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Read-only memory mapping of a whole file (mmap / MapViewOfFile).
+// Valid() is false if the file could not be opened or is empty.
+//
+
+class MappedFile
+{
+public:
+	explicit				MappedFile(const std::string & fileName);
+							~MappedFile();
+
+	bool					Valid() const			{ return m_pData != nullptr; }
+	const uint8_t *			Data() const			{ return m_pData; }
+	size_t					Size() const			{ return m_size; }
+
+							MappedFile(const MappedFile &) = delete;
+	MappedFile &			operator=(const MappedFile &) = delete;
+
+private:
+	const uint8_t *			m_pData = nullptr;
+	size_t					m_size = 0;
+#ifdef _WIN32
+	void *					m_hFile = nullptr;
+	void *					m_hMapping = nullptr;
+#endif
+};
+
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class CacheWriter / CacheReader
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Minimal binary (de)serialization helpers for the analysis cache (Cf. Map::Initialize(source, cacheFileName)).
+// The cache is a private, machine-local file, so values are stored in native byte order:
+// the header records a byte order marker and the sizes of the raw arrays, and a mismatch just invalidates the cache.
+// CacheReader reads directly from a MappedFile and throws an Exception on any out of bounds access.
+//
+
+class CacheWriter
+{
+public:
+	explicit				CacheWriter(const std::string & fileName) : m_out(fileName, std::ios::binary | std::ios::trunc) {}
+
+	bool					Good() const			{ return static_cast<bool>(m_out); }
+
+	template<class T>
+	void					Write(const T & v)		{ static_assert(std::is_arithmetic<T>::value, "arithmetic types only"); m_out.write(reinterpret_cast<const char *>(&v), sizeof(T)); }
+
+	template<class T, int Scale>
+	void					Write(const Sc2Bindings::Point<T, Scale> & p)	{ Write(p.x); Write(p.y); }
+
+	void					WriteBytes(const void * p, size_t n)			{ m_out.write(static_cast<const char *>(p), n); }
+
+private:
+	std::ofstream			m_out;
+};
+
+
+class CacheReader
+{
+public:
+							CacheReader(const uint8_t * pData, size_t size) : m_pData(pData), m_size(size) {}
+
+	template<class T>
+	T						Read()					{ static_assert(std::is_arithmetic<T>::value, "arithmetic types only"); T v; memcpy(&v, Take(sizeof(T)), sizeof(T)); return v; }
+
+	template<class TPosition>
+	TPosition				ReadPosition()			{ TPosition p; p.x = Read<decltype(p.x)>(); p.y = Read<decltype(p.y)>(); return p; }
+
+	// Returns a pointer to the next n bytes, which remain valid as long as the underlying MappedFile.
+	const uint8_t *			ReadBytes(size_t n)		{ return Take(n); }
+
+	// Reads a count, checking it is not greater than limit.
+	int						ReadCount(int limit)	{ int n = Read<int32_t>(); if ((n < 0) || (n > limit)) throw Exception("analysis cache: invalid count"); return n; }
+
+	bool					AtEnd() const			{ return m_pos == m_size; }
+
+private:
+	const uint8_t *			Take(size_t n)			{ if (n > m_size - m_pos) throw Exception("analysis cache: unexpected end of file"); const uint8_t * p = m_pData + m_pos; m_pos += n; return p; }
+
+	const uint8_t *			m_pData;
+	size_t					m_size;
+	size_t					m_pos = 0;
+};
+
+
+// 64-bit FNV-1a hash, used as the key of the analysis cache.
+class Fnv1a
+{
+public:
+	void					Add(const void * p, size_t n)	{ const uint8_t * b = static_cast<const uint8_t *>(p); for (size_t i = 0 ; i < n ; ++i) { m_hash ^= b[i]; m_hash *= 1099511628211ull; } }
+
+	template<class T>
+	void					Add(const T & v)				{ static_assert(std::is_arithmetic<T>::value, "arithmetic types only"); Add(&v, sizeof(T)); }
+
+	uint64_t				Value() const					{ return m_hash; }
+
+private:
+	uint64_t				m_hash = 14695981039346656037ull;
+};
+
+
+
+}} // namespace SC2EM::detail
+
+
+#endif
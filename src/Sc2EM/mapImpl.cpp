@@ -10,6 +10,8 @@
 
 #include "mapImpl.h"
 #include "neutral.h"
+#include "mapSource.h"
+#include "mapCache.h"
 #include "bwapiExt.h"
 #include "winutils.h"
 
@@ -60,93 +62,397 @@ MapImpl::MapImpl()
 MapImpl::~MapImpl()
 {
 	m_automaticPathUpdate = false;		// now there is no need to update the paths
+
+	// The Neutrals update the summed-area tables when they are destroyed, so they must be destroyed before them:
+	m_StaticBuildings.clear();
+	m_Geysers.clear();
+	m_Minerals.clear();
 }
 
 
 void MapImpl::Initialize(const ObservationInterface *obs)
+{
+	Initialize(ObservationMapSource(obs));
+}
+
+
+// Reads the pathing and placement grids of source, one bit per MiniTile (Cf. MapSource::ReadGrids).
+static void readGrids(const MapSource & source, utils::BitGrid & Pathable, utils::BitGrid & Placable)
+{
+	const int width = 4 * static_cast<int>(source.Size().x);
+	const int height = 4 * static_cast<int>(source.Size().y);
+	Pathable = utils::BitGrid(width, height);
+	Placable = utils::BitGrid(width, height);
+	source.ReadGrids(Pathable, Placable);
+}
+
+
+void MapImpl::Initialize(const MapSource & source)
+{
+	InitializationStats Stats;		// local, as Reset destroys m_InitializationStats
+	Stats.BeginStage();
+
+	Reset(source);
+	Stats.EndStage("Reset");
+
+	utils::BitGrid Pathable, Placable;
+	readGrids(source, Pathable, Placable);
+	LoadData(source, Pathable, Placable);
+	Stats.EndStage("LoadData");
+	
+	DecideSeasOrLakes();
+	Stats.EndStage("DecideSeasOrLakes");
+
+	InitializeNeutrals(source);
+	Stats.EndStage("InitializeNeutrals");
+
+	ComputeAltitude();
+	Stats.EndStage("ComputeAltitude");
+
+	ProcessBlockingNeutrals();
+	Stats.EndStage("ProcessBlockingNeutrals");
+
+	ComputeAreas();
+	Stats.EndStage("ComputeAreas");
+
+	GetGraph().CreateChokePoints();
+	Stats.EndStage("Graph::CreateChokePoints");
+
+	GetGraph().ComputeChokePointDistanceMatrix();
+	Stats.EndStage("Graph::ComputeChokePointDistanceMatrix");
+
+	GetGraph().CollectInformation();
+	Stats.EndStage("Graph::CollectInformation");
+
+	GetGraph().CreateBases();
+	Stats.EndStage("Graph::CreateBases");
+
+	GetGraph().ComputeLandmarks();
+	Stats.EndStage("Graph::ComputeLandmarks");
+
+	ComputeSummedAreaTables();
+	Stats.EndStage("ComputeSummedAreaTables");
+
+	m_InitializationStats = Stats;
+}
+
+
+void MapImpl::Initialize(const MapSource & source, const string & cacheFileName)
+{
+	InitializationStats Stats;
+	Stats.BeginStage();
+
+	// The key only depends on the raw grids and units of source, so that a cache file written for another map
+	// is rejected before any analysis.
+	utils::BitGrid Pathable, Placable;
+	readGrids(source, Pathable, Placable);
+	const uint64_t key = SourceKey(source, Pathable, Placable);
+
+	try
+	{
+		if (LoadCache(source, Pathable, Placable, key, cacheFileName))
+		{
+			Stats.EndStage("LoadCache");
+			Stats.SetFromCache(true);
+			m_InitializationStats = Stats;
+			m_initializedFromCache = true;
+			return;
+		}
+	}
+	catch (const Exception &) {}		// corrupted cache file: just recompute it
+
+	Initialize(source);
+
+	m_InitializationStats.BeginStage();
+	SaveCache(key, cacheFileName);
+	m_InitializationStats.EndStage("SaveCache");
+}
+
+
+// Resets this MapImpl to a fresh state, sized according to source.
+void MapImpl::Reset(const MapSource & source)
 {
 	this->~MapImpl();
-    new (this) MapImpl();
+	new (this) MapImpl();
 
-///	Timer overallTimer;
-///	Timer timer;
-	m_TileSize = TilePositionFromPoint2D(obs->GetGameInfo().playable_max);
+	m_TileSize = source.Size();
 	m_size = Size().x * Size().y;
 	m_Tiles.resize(static_cast<size_t>(round(m_size)));
 
 	m_WalkSizePosition = WalkPosition(Size());
 	m_walkSize = WalkSize().x * WalkSize().y;
+	m_walkWidth = static_cast<int>(WalkSize().x);
+	m_walkHeight = static_cast<int>(WalkSize().y);
 	m_MiniTiles.resize(static_cast<size_t>(round(m_walkSize)));
 
 	m_center = Position(Size())/2;
 
-	for (Point2D t : obs->GetGameInfo().start_locations)
+	for (Point2D t : source.StartLocations())
 	{
 		m_StartingLocations.push_back(TilePositionFromPoint2D(t));
 	}
+}
 
 
-///	bw << "Map::Initialize-resize: " << timer.ElapsedMilliseconds() << " ms" << endl; timer.Reset();
-	
-	LoadData(obs);
-///	bw << "Map::LoadData: " << timer.ElapsedMilliseconds() << " ms" << endl; timer.Reset();
-	
-	DecideSeasOrLakes();
-///	bw << "Map::DecideSeasOrLakes: " << timer.ElapsedMilliseconds() << " ms" << endl; timer.Reset();
+//////////////////////////////////////////////////////////////////////////////////////////////
+//	Analysis cache
+//
+// The cache file holds everything the analysis computes from LoadData's output and the neutrals:
+// the MiniTile and Tile arrays, the raw frontier, the blocking neutrals, and the Graph (Areas, ChokePoints,
+// distance and path matrices, Bases, landmarks). Only the cheap steps (LoadData, InitializeNeutrals, CollectInformation
+// and the group ids) are replayed when it is loaded.
+// Neutrals are referred to by their index in CanonicalNeutrals(), which does not depend on the order of the units in the game.
+// The file is keyed by SourceKey, a hash of the raw inputs, so that an outdated file is rejected before LoadData is even run.
 
-	InitializeNeutrals(obs);
-///	bw << "Map::InitializeNeutrals: " << timer.ElapsedMilliseconds() << " ms" << endl; timer.Reset();
+static const char cacheMagic[8] = { 'S', 'C', '2', 'E', 'M', 'C', 'A', 'C' };
+static const uint32_t cacheVersion = 6;
+static const uint32_t cacheByteOrderMark = 0x01020304;
 
-	ComputeAltitude();
-///	bw << "Map::ComputeAltitude: " << timer.ElapsedMilliseconds() << " ms" << endl; timer.Reset();
 
-	ProcessBlockingNeutrals();
-///	bw << "Map::ProcessBlockingNeutrals: " << timer.ElapsedMilliseconds() << " ms" << endl; timer.Reset();
+vector<Neutral *> MapImpl::CanonicalNeutrals() const
+{
+	vector<Neutral *> Neutrals;
+	for (auto & s : StaticBuildings())	Neutrals.push_back(s.get());
+	for (auto & m : Minerals())			Neutrals.push_back(m.get());
+	for (auto & g : Geysers())			Neutrals.push_back(g.get());
 
-	ComputeAreas();
-///	bw << "Map::ComputeAreas: " << timer.ElapsedMilliseconds() << " ms" << endl; timer.Reset();
+	stable_sort(Neutrals.begin(), Neutrals.end(), [](const Neutral * a, const Neutral * b)
+	{
+		const uint32_t typeA = static_cast<uint32_t>(a->GetUnit().unit_type.ToType());
+		const uint32_t typeB = static_cast<uint32_t>(b->GetUnit().unit_type.ToType());
+		if (typeA != typeB) return typeA < typeB;
+		if (a->Pos().x != b->Pos().x) return a->Pos().x < b->Pos().x;
+		return a->Pos().y < b->Pos().y;
+	});
+
+	return Neutrals;
+}
 
-	GetGraph().CreateChokePoints();
-///	bw << "Graph::CreateChokePoints: " << timer.ElapsedMilliseconds() << " ms" << endl; timer.Reset();
 
-	GetGraph().ComputeChokePointDistanceMatrix();
-///	bw << "Graph::ComputeChokePointDistanceMatrix: " << timer.ElapsedMilliseconds() << " ms" << endl; timer.Reset();
+// Hashes the inputs of the analysis, as given by source. Pathable and Placable are the grids read from source (Cf. readGrids).
+// Only the neutral units the analysis uses are hashed, in the canonical order (Cf. CanonicalNeutrals).
+uint64_t MapImpl::SourceKey(const MapSource & source, const utils::BitGrid & Pathable, const utils::BitGrid & Placable)
+{
+	Fnv1a hash;
+	const TilePosition size = source.Size();
+	hash.Add(size.x);
+	hash.Add(size.y);
 
-	GetGraph().CollectInformation();
-///	bw << "Graph::CollectInformation: " << timer.ElapsedMilliseconds() << " ms" << endl; timer.Reset();
+	for (const Point2D & p : source.StartLocations())
+	{
+		hash.Add(p.x);
+		hash.Add(p.y);
+	}
 
-	GetGraph().CreateBases();
-///	bw << "Graph::CreateBases: " << timer.ElapsedMilliseconds() << " ms" << endl; timer.Reset();
+	for (const utils::BitGrid * pGrid : {&Pathable, &Placable})
+		for (int y = 0 ; y < pGrid->Height() ; ++y)
+			for (int k = 0 ; k < pGrid->WordsPerRow() ; ++k)
+				hash.Add(pGrid->Row(y)[k] & ~(k == pGrid->WordsPerRow() - 1 ? pGrid->PaddingMask() : 0));
 
-///	bw << "Map::Initialize: " << overallTimer.ElapsedMilliseconds() << " ms" << endl;
+	for (int y = 0 ; y < size.y ; ++y)
+	for (int x = 0 ; x < size.x ; ++x)
+		hash.Add(int32_t(source.TerrainHeight(Point2D(float(x), float(y)))));		// Cf. LoadData
+
+	vector<sc2::Unit> Neutrals;
+	for (const sc2::Unit & n : source.NeutralUnits())
+		if (Sc2Bindings::IsMineralField(n.unit_type) || Sc2Bindings::IsVespeneGeyser(n.unit_type) || Sc2Bindings::IsStaticNeutral(n.unit_type))
+			Neutrals.push_back(n);
+
+	stable_sort(Neutrals.begin(), Neutrals.end(), [](const sc2::Unit & a, const sc2::Unit & b)
+	{
+		const uint32_t typeA = static_cast<uint32_t>(a.unit_type.ToType());
+		const uint32_t typeB = static_cast<uint32_t>(b.unit_type.ToType());
+		if (typeA != typeB) return typeA < typeB;
+		if (a.pos.x != b.pos.x) return a.pos.x < b.pos.x;
+		return a.pos.y < b.pos.y;
+	});
+
+	for (const sc2::Unit & n : Neutrals)
+	{
+		hash.Add(static_cast<uint32_t>(n.unit_type.ToType()));
+		hash.Add(n.pos.x);
+		hash.Add(n.pos.y);
+		hash.Add(n.radius);
+		hash.Add(int32_t(n.mineral_contents));
+		hash.Add(int32_t(n.vespene_contents));
+	}
+
+	return hash.Value();
 }
 
 
-// Computes walkability, buildability and groundHeight and doodad information, using BWAPI corresponding functions
-void MapImpl::LoadData(const ObservationInterface *obs)
+bool MapImpl::LoadCache(const MapSource & source, const utils::BitGrid & Pathable, const utils::BitGrid & Placable,
+						uint64_t key, const string & fileName)
 {
-	// Mark unwalkable minitiles (minitiles are walkable by default)
-	for (int y = 0; y < WalkSize().y; ++y)
+	MappedFile file(fileName);
+	if (!file.Valid()) return false;
+
+	CacheReader in(file.Data(), file.Size());
+	if (memcmp(in.ReadBytes(sizeof(cacheMagic)), cacheMagic, sizeof(cacheMagic)) != 0) return false;
+	if (in.Read<uint32_t>() != cacheVersion) return false;
+	if (in.Read<uint32_t>() != cacheByteOrderMark) return false;
+	if (in.Read<uint32_t>() != sizeof(MiniTile)) return false;
+	if (in.Read<uint64_t>() != key) return false;
+
+	Reset(source);
+	LoadData(source, Pathable, Placable);
+	InitializeNeutrals(source);
+
+	const vector<Neutral *> Neutrals = CanonicalNeutrals();
+
+	m_maxAltitude = in.Read<altitude_t>();
+
+	memcpy(m_MiniTiles.data(), in.ReadBytes(m_MiniTiles.size() * sizeof(MiniTile)), m_MiniTiles.size() * sizeof(MiniTile));
+
+	for (Tile & tile : m_Tiles)
+	{
+		tile.SetMinAltitude(in.Read<altitude_t>());
+		if (Area::id id = in.Read<Area::id>()) tile.SetAreaId(id);
+	}
+
+	m_RawFrontier.resize(in.ReadCount(int(m_MiniTiles.size())));
+	for (auto & f : m_RawFrontier)
+	{
+		f.first.first = in.Read<Area::id>();
+		f.first.second = in.Read<Area::id>();
+		f.second = in.ReadPosition<WalkCoord>();
+	}
+
+	for (int n = in.ReadCount(int(Neutrals.size())) ; n ; --n)
 	{
-		for (int x = 0; x < WalkSize().x; ++x)
+		Neutral * pNeutral = Neutrals[in.ReadCount(int(Neutrals.size()) - 1)];
+		vector<WalkPosition> TrueDoors(in.ReadCount(int(m_MiniTiles.size())));
+		for (WalkPosition & door : TrueDoors)
+			door = in.ReadPosition<WalkPosition>();
+
+		pNeutral->SetBlocking(TrueDoors);
+	}
+
+	GetGraph().LoadCache(in, Neutrals);
+
+	ComputeSummedAreaTables();		// cheap enough not to be cached
+
+	return in.AtEnd();
+}
+
+
+void MapImpl::SaveCache(uint64_t key, const string & fileName) const
+{
+	CacheWriter out(fileName);
+	if (!out.Good()) return;		// the cache is optional: the analysis is still usable
+
+	out.WriteBytes(cacheMagic, sizeof(cacheMagic));
+	out.Write(cacheVersion);
+	out.Write(cacheByteOrderMark);
+	out.Write(uint32_t(sizeof(MiniTile)));
+	out.Write(key);
+
+	const vector<Neutral *> Neutrals = CanonicalNeutrals();
+	map<const Neutral *, int> NeutralIndex;
+	for (int i = 0 ; i < (int)Neutrals.size() ; ++i)
+		NeutralIndex[Neutrals[i]] = i;
+
+	out.Write(m_maxAltitude);
+
+	out.WriteBytes(m_MiniTiles.data(), m_MiniTiles.size() * sizeof(MiniTile));
+
+	for (const Tile & tile : m_Tiles)
+	{
+		out.Write(tile.MinAltitude());
+		out.Write(tile.AreaId());
+	}
+
+	out.Write(int32_t(m_RawFrontier.size()));
+	for (const auto & f : m_RawFrontier)
+	{
+		out.Write(f.first.first);
+		out.Write(f.first.second);
+		out.Write(f.second);
+	}
+
+	vector<const Neutral *> BlockingNeutrals;
+	for (const Neutral * n : Neutrals)
+		if (n->Blocking()) BlockingNeutrals.push_back(n);
+
+	out.Write(int32_t(BlockingNeutrals.size()));
+	for (const Neutral * n : BlockingNeutrals)
+	{
+		out.Write(int32_t(NeutralIndex[n]));
+		out.Write(int32_t(n->BlockingDoors().size()));
+		for (WalkPosition door : n->BlockingDoors())
+			out.Write(door);
+	}
+
+	GetGraph().SaveCache(out, NeutralIndex);
+}
+
+
+// Computes walkability, buildability and groundHeight and doodad information, using the MapSource grids and queries.
+// Pathable and Placable are the terrain grids of source, read once as bits (Cf. readGrids).
+void MapImpl::LoadData(const MapSource & source, const utils::BitGrid & Pathable, const utils::BitGrid & Placable)
+{
+	typedef utils::BitGrid::word_t word_t;
+	const int width = static_cast<int>(WalkSize().x);
+	const int height = static_cast<int>(WalkSize().y);
+	bwem_assert((Pathable.Width() == width) && (Pathable.Height() == height));
+
+	// Mark unwalkable minitiles (minitiles are walkable by default).
+	// For each unwalkable minitile, we also mark its 8 neighbours as not walkable.
+	// According to some tests, this prevents from wrongly pretending one Marine can go by some thin path.
+	// This is a 3x3 erosion of the open (pathable or placable) minitiles, where the outside of the map counts as open.
+	// It is separable: a horizontal pass, 64 minitiles at a time, then a vertical one. Each pass processes the rows in parallel.
+	const int words = Pathable.WordsPerRow();
+	const word_t padding = Pathable.PaddingMask();
+	const word_t ones = ~word_t(0);
+	const int bits = utils::BitGrid::bits_per_word;
+
+	utils::BitGrid Eroded(width, height);
+	utils::parallel_for(0, height, [&](int y)
+	{
+		const word_t * pPathable = Pathable.Row(y);
+		const word_t * pPlacable = Placable.Row(y);
+		word_t * pEroded = Eroded.Row(y);
+
+		auto open = [&](int k) { return (k == words) ? ones : (pPathable[k] | pPlacable[k] | (k == words-1 ? padding : 0)); };
+
+		word_t prev = ones;
+		word_t cur = open(0);
+		for (int k = 0 ; k < words ; ++k)
 		{
-			sc2::Point2D tilePos(x, y);
-			if (!(obs->IsPathable(Point2D(tilePos.x, tilePos.y)) || obs->IsPlacable(Point2D(tilePos.x, tilePos.y))))						// For each unwalkable minitile, we also mark its 8 neighbours as not walkable.
+			const word_t next = open(k+1);
+			pEroded[k] = cur & ((cur << 1) | (prev >> (bits - 1)))
+							 & ((cur >> 1) | (next << (bits - 1)));
+			prev = cur;
+			cur = next;
+		}
+	});
+
+	m_WalkabilityGrid = utils::BitGrid(width, height);
+	utils::parallel_for(0, height, [&](int y)
+	{
+		const word_t * pAbove = (y > 0) ? Eroded.Row(y-1) : nullptr;
+		const word_t * pRow = Eroded.Row(y);
+		const word_t * pBelow = (y+1 < height) ? Eroded.Row(y+1) : nullptr;
+		const word_t * pBuildable = Placable.Row(y/4);		// Cf. the buildable Tiles below
+		word_t * pWalkable = m_WalkabilityGrid.Row(y);
+		MiniTile * pMiniTile = &m_MiniTiles[size_t(y) * width];
+
+		for (int k = 0 ; k < words ; ++k)
+		{
+			word_t walkable = pRow[k] & (pAbove ? pAbove[k] : ones) & (pBelow ? pBelow[k] : ones);
+			for (int x = k * bits, last = min(width, x + bits) ; x < last ; ++x)
 			{
-				for (int dy = -1; dy <= +1; ++dy)			// According to some tests, this prevents from wrongly pretending one Marine can go by some thin path.
-				{
-					for (int dx = -1; dx <= +1; ++dx)
-					{
-						WalkPosition w(static_cast<float>(x + dx), static_cast<float>(y + dy));
-						if (Valid(w))
-						{
-							GetMiniTile_(w, check_t::no_check).SetWalkable(false);
-						}
-					}
-				}
+				// Ensures buildable ==> walkable:
+				if ((pBuildable[(x/4) / bits] >> ((x/4) % bits)) & 1)
+					walkable |= word_t(1) << (x % bits);
+
+				pMiniTile[x].SetWalkable(((walkable >> (x % bits)) & 1) != 0);
 			}
+
+			pWalkable[k] = walkable & ~(k == words-1 ? padding : 0);
 		}
-	}
+	});
+
 	// Mark buildable tiles (tiles are unbuildable by default)
 	for (int y = 0; y < Size().y; ++y)
 	{
@@ -155,22 +461,13 @@ void MapImpl::LoadData(const ObservationInterface *obs)
 		{
 			TilePosition t(static_cast<float>(x), static_cast<float>(y));
 			sc2::Point2D tilePos(x, y);
-			if (obs->IsPlacable(Point2D(tilePos.x, tilePos.y)))
+			if (Placable.Get(x, y))
 			{
 				GetTile_(t).SetBuildable();
-
-				// Ensures buildable ==> walkable:
-				for (int dy = 0; dy < 4; ++dy)
-				{
-					for (int dx = 0; dx < 4; ++dx)
-					{
-						GetMiniTile_(WalkPosition(t) + WalkPosition(static_cast<float>(dx), static_cast<float>(dy)), check_t::no_check).SetWalkable(true);
-					}
-				}
 			}
 
 			// Add groundHeight and doodad information:
-			int bwapiGroundHeight = obs->TerrainHeight(tilePos);
+			int bwapiGroundHeight = source.TerrainHeight(tilePos);
 			GetTile_(t).SetGroundHeight(bwapiGroundHeight / 2);
 			if (bwapiGroundHeight % 2)
 			{
@@ -181,215 +478,224 @@ void MapImpl::LoadData(const ObservationInterface *obs)
 }
 
 
+// The SeaOrLake MiniTiles are grouped into 4-connected components by a two-scan connected-component labelling:
+//	1) Each SeaOrLake MiniTile takes the label of its left or upper neighbour, or a new label if it has none.
+//	   If both neighbours are labelled, their labels are merged (union-find).
+//	2) Each label is replaced by the root of its set, and the MiniTile is counted in the size and the bounding box of that root.
+// The lakes are the small components (Cf. lake_max_miniTiles and lake_max_width_in_miniTiles) that do not touch the border of the Map.
+// A last scan then sets each MiniTile to sea or lake, according to its component.
+// Unlike a search from each component, the memory is allocated once whatever the number of components.
 void MapImpl::DecideSeasOrLakes()
 {
-	for (float y = 0 ; y < WalkSize().y ; ++y)
+	const int width = static_cast<int>(WalkSize().x);
+	const int height = static_cast<int>(WalkSize().y);
+	const int bits = utils::BitGrid::bits_per_word;
+
+	vector<int> Labels(size_t(width) * height, -1);		// index == y * width + x ; -1 for the MiniTiles that are not SeaOrLake
+	vector<int> Parents;									// the union-find forest of the labels ; each root is its smallest label
+	const auto root = [&Parents](int label)
+	{
+		while (Parents[label] != label) label = Parents[label] = Parents[Parents[label]];
+		return label;
+	};
+
+	// 1) First scan:
+	for (int y = 0 ; y < height ; ++y)
 	{
-		for (float x = 0 ; x < WalkSize().x ; ++x)
+		for (int x = 0 ; x < width ; ++x)
 		{
-			WalkPosition origin = WalkPosition(x, y);
-			MiniTile & Origin = GetMiniTile_(origin, check_t::no_check);
-			if (Origin.SeaOrLake())
+			// Only unwalkable MiniTiles can be SeaOrLake: skips the fully walkable words.
+			if ((x % bits == 0) && (m_WalkabilityGrid.Row(y)[x / bits] == ~utils::BitGrid::word_t(0)))
 			{
-				vector<WalkPosition> ToSearch{ origin };
-				vector<MiniTile *> SeaExtent{ &Origin };
-				Origin.SetSea();
-				WalkPosition topLeft = origin;
-				WalkPosition bottomRight = origin;
-				while (!ToSearch.empty())
-				{
-					WalkPosition current = ToSearch.back();
-					if (current.x < topLeft.x)
-					{
-						topLeft.x = current.x;
-					}
-					if (current.y < topLeft.y)
-					{
-						topLeft.y = current.y;
-					}
-					if (current.x > bottomRight.x)
-					{
-						bottomRight.x = current.x;
-					}
-					if (current.y > bottomRight.y)
-					{
-						bottomRight.y = current.y;
-					}
-					ToSearch.pop_back();
-					for (WalkPosition delta : {WalkPosition(0, -1), WalkPosition(-1, 0), WalkPosition(+1, 0), WalkPosition(0, +1)})
-					{
-						WalkPosition next = current + delta;
-						if (Valid(next))
-						{
-							MiniTile & Next = GetMiniTile_(next, check_t::no_check);
-							if (Next.SeaOrLake())
-							{
-								ToSearch.push_back(next);
-								if (SeaExtent.size() <= lake_max_miniTiles)
-								{
-									SeaExtent.push_back(&Next);
-								}
-								Next.SetSea();
-							}
-						}
-					}
-				}
+				x += bits - 1;
+				continue;
+			}
+
+			if (!GetMiniTile_(WalkCoord(x, y), check_t::no_check).SeaOrLake()) continue;
 
-				if ((SeaExtent.size() <= lake_max_miniTiles) &&
-					(bottomRight.x - topLeft.x <= lake_max_width_in_miniTiles) &&
-					(bottomRight.y - topLeft.y <= lake_max_width_in_miniTiles) &&
-					(topLeft.x >= 2) && (topLeft.y >= 2) && (bottomRight.x < WalkSize().x - 2) && (bottomRight.y < WalkSize().y - 2))
+			const int i = y * width + x;
+			const int left = (x > 0) ? Labels[i - 1] : -1;
+			const int up = (y > 0) ? Labels[i - width] : -1;
+			if ((left == -1) && (up == -1))
+			{
+				Labels[i] = int(Parents.size());
+				Parents.push_back(Labels[i]);
+			}
+			else if (up == -1) Labels[i] = left;
+			else
+			{
+				Labels[i] = up;
+				if (left != -1)
 				{
-					for (MiniTile * pSea : SeaExtent)
-					{
-						pSea->SetLake();
-					}
+					const int rootLeft = root(left);
+					const int rootUp = root(up);
+					if (rootLeft != rootUp) Parents[max(rootLeft, rootUp)] = min(rootLeft, rootUp);
 				}
 			}
 		}
 	}
-}
-
 
-void MapImpl::InitializeNeutrals(const ObservationInterface *obs)
-{
-	for (auto & n : obs->GetUnits(sc2::Unit::Alliance::Neutral))
+	// 2) Second scan: the size and the bounding box of each component, indexed by its root.
+	struct Component
 	{
-		if (Sc2Bindings::IsMineralField(n->unit_type))
-		{
-			m_Minerals.push_back(make_unique<Mineral>(*n, this));
-		}
-		else if (Sc2Bindings::IsVespeneGeyser(n->unit_type))
+		int			size = 0;
+		WalkCoord	topLeft;
+		WalkCoord	bottomRight;
+		bool		lake = false;
+	};
+	vector<Component> Components(Parents.size());
+
+	for (int y = 0 ; y < height ; ++y)
+		for (int x = 0 ; x < width ; ++x)
 		{
-			m_Geysers.push_back(make_unique<Geyser>(*n, this));
+			int & label = Labels[y * width + x];
+			if (label == -1) continue;
+
+			label = root(label);
+			Component & C = Components[label];
+			const WalkCoord w(x, y);
+			if (C.size++ == 0) C.topLeft = C.bottomRight = w;
+			else
+			{
+				C.topLeft.x = min(C.topLeft.x, w.x);
+				C.topLeft.y = min(C.topLeft.y, w.y);
+				C.bottomRight.x = max(C.bottomRight.x, w.x);
+				C.bottomRight.y = max(C.bottomRight.y, w.y);
+			}
 		}
-		else if (Sc2Bindings::IsStaticNeutral(n->unit_type))
+
+	for (Component & C : Components) if (C.size > 0)
+		C.lake = (C.size <= lake_max_miniTiles) &&
+				(C.bottomRight.x - C.topLeft.x <= lake_max_width_in_miniTiles) &&
+				(C.bottomRight.y - C.topLeft.y <= lake_max_width_in_miniTiles) &&
+				(C.topLeft.x >= 2) && (C.topLeft.y >= 2) && (C.bottomRight.x < width - 2) && (C.bottomRight.y < height - 2);
+
+	// 3) Last scan:
+	for (int y = 0 ; y < height ; ++y)
+		for (int x = 0 ; x < width ; ++x)
 		{
-			m_StaticBuildings.push_back(make_unique<StaticBuilding>(*n, this));
+			const int label = Labels[y * width + x];
+			if (label == -1) continue;
+
+			MiniTile & miniTile = GetMiniTile_(WalkCoord(x, y), check_t::no_check);
+			miniTile.SetSea();
+			if (Components[label].lake) miniTile.SetLake();
 		}
-	}
 }
 
 
-void MapImpl::ReplaceAreaIds(Sc2Bindings::WalkPosition p, Area::id newAreaId)
+void MapImpl::InitializeNeutrals(const MapSource & source)
 {
-	MiniTile & Origin = GetMiniTile_(p, check_t::no_check);
-	Area::id oldAreaId = Origin.AreaId();
-	Origin.ReplaceAreaId(newAreaId);
-
-	vector<WalkPosition> ToSearch{p};
-	while (!ToSearch.empty())
+	for (const sc2::Unit & n : source.NeutralUnits())
 	{
-		WalkPosition current = ToSearch.back();
-
-		ToSearch.pop_back();
-		for (WalkPosition delta : {WalkPosition(0, -1), WalkPosition(-1, 0), WalkPosition(+1, 0), WalkPosition(0, +1)})
+		if (Sc2Bindings::IsMineralField(n.unit_type))
 		{
-			WalkPosition next = current + delta;
-			if (Valid(next))
-			{
-				MiniTile & Next = GetMiniTile_(next, check_t::no_check);
-				if (Next.AreaId() == oldAreaId)
-				{
-					ToSearch.push_back(next);
-					Next.ReplaceAreaId(newAreaId);
-				}
-			}
+			m_Minerals.push_back(make_unique<Mineral>(n, this));
 		}
-	}
-
-	// also replaces references of oldAreaId by newAreaId in m_RawFrontier:
-	if (newAreaId > 0)
-		for (auto & f : m_RawFrontier)
+		else if (Sc2Bindings::IsVespeneGeyser(n.unit_type))
+		{
+			m_Geysers.push_back(make_unique<Geyser>(n, this));
+		}
+		else if (Sc2Bindings::IsStaticNeutral(n.unit_type))
 		{
-			if (f.first.first == oldAreaId) f.first.first = newAreaId;
-			if (f.first.second == oldAreaId) f.first.second = newAreaId;
+			m_StaticBuildings.push_back(make_unique<StaticBuilding>(n, this));
 		}
+	}
 }
 
 
-// Assigns MiniTile::m_altitude foar each miniTile having AltitudeMissing()
+// Assigns MiniTile::m_altitude for each miniTile having AltitudeMissing()
 // Cf. MiniTile::Altitude() for meaning of altitude_t.
-// Altitudes are computed using the straightforward Dijkstra's algorithm : the lower ones are computed first, starting from the seaside-miniTiles neighbours.
-// The point here is to precompute all possible altitudes for all possible tiles, and sort them.
+// Altitudes are computed by an exact euclidean distance transform (see below), in time linear in the number of MiniTiles.
 void MapImpl::ComputeAltitude()
 {
 	const int altitude_scale = 8;	// 8 provides a pixel definition for altitude_t, since altitudes are computed from miniTiles which are 8x8 pixels
 
-	// 1) Fill in and sort DeltasByAscendingAltitude
-	const int range = max(WalkSize().x, WalkSize().y) / 2 + 3;		// should suffice for maps with no Sea.
-	
-	vector<pair<WalkPosition, altitude_t>> DeltasByAscendingAltitude;
-
-	for (int dy = 0; dy <= range; ++dy)
+	// The altitude of a MiniTile is its euclidean distance to the nearest Sea-MiniTile or to the nearest MiniTile outside the Map.
+	// It is computed exactly, in linear time, using the separable distance transform of Meijster, Roerdink and Hesselink:
+	// the Map is extended with a border of one MiniTile, and the border MiniTiles and the Sea-MiniTiles are the sources.
+	// Note: the nearest Sea-MiniTile of a non-Sea-MiniTile is always a seaside one (Cf. seaSide).
+	const int width = WalkSize().x + 2;
+	const int height = WalkSize().y + 2;
+	auto source = [this](int x, int y)
 	{
-		for (int dx = dy; dx <= range; ++dx)			// Only consider 1/8 of possible deltas. Other ones obtained by symmetry.
-		{
-			if (dx || dy)
-			{
-				DeltasByAscendingAltitude.emplace_back(WalkPosition(dx, dy), altitude_t(0.5 + norm(dx, dy) * altitude_scale));
-			}
-		}
-	}
-
-	sort(DeltasByAscendingAltitude.begin(), DeltasByAscendingAltitude.end(),
-		[](const pair<WalkPosition, altitude_t> & a, const pair<WalkPosition, altitude_t> & b)
-		{ 
-			return a.second < b.second; 
-		}
-	);
-
-
-	// 2) Fill in ActiveSeaSideList, which basically contains all the seaside miniTiles (from which altitudes are to be computed)
-	//    It also includes extra border-miniTiles which are considered as seaside miniTiles too.
-	struct ActiveSeaSide { WalkPosition origin; altitude_t lastAltitudeGenerated; };
-	vector<ActiveSeaSide> ActiveSeaSideList;
-
-	for (int y = -1; y <= WalkSize().y; ++y)
+		const WalkPosition w(static_cast<float>(x - 1), static_cast<float>(y - 1));
+		return !Valid(w) || GetMiniTile(w, check_t::no_check).Sea();
+	};
+
+	// 1) Column pass: G[y*width + x] = distance from (x, y) to the nearest source in column x.
+	//    The first and last rows are border MiniTiles, so there always is such a source.
+	vector<int> G(width * height, 0);
+	for (int x = 0 ; x < width ; ++x)
 	{
-		for (int x = -1; x <= WalkSize().x; ++x)
-		{
-			WalkPosition w(x, y);
-			if (!Valid(w) || seaSide(w, this))
-			{
-				ActiveSeaSideList.push_back(ActiveSeaSide{ w, 0 });
-			}
-		}
+		for (int y = 1 ; y < height ; ++y)
+			if (!source(x, y)) G[y*width + x] = G[(y-1)*width + x] + 1;
+
+		for (int y = height - 2 ; y >= 0 ; --y)
+			G[y*width + x] = min(G[y*width + x], G[(y+1)*width + x] + 1);
 	}
 
-	// 3) Dijkstra's algorithm
-	for (const auto & delta_altitude : DeltasByAscendingAltitude)
+	// 2) Row pass: lower envelope of the parabolas (x - u)^2 + G(u)^2, u being the columns of the current row.
+	vector<int> S(width);	// columns of the parabolas of the envelope
+	vector<int> T(width);	// first column where each parabola of the envelope is the lowest one
+	m_maxAltitude = 0;
+	for (int y = 1 ; y < height - 1 ; ++y)
 	{
-		const WalkPosition d = delta_altitude.first;
-		const altitude_t altitude = delta_altitude.second;
-		for (int i = 0 ; i < (int)ActiveSeaSideList.size() ; ++i)
+		const int * g = &G[y*width];
+		auto f = [g](int x, int u) { return (x - u)*(x - u) + g[u]*g[u]; };
+		auto sep = [g](int i, int u)		// floor((u^2 - i^2 + g(u)^2 - g(i)^2) / (2(u - i)))
 		{
-			ActiveSeaSide & Current = ActiveSeaSideList[i];
-			if (altitude - Current.lastAltitudeGenerated >= 2 * altitude_scale)		// optimization : once a seaside miniTile verifies this condition, 
+			const int num = u*u - i*i + g[u]*g[u] - g[i]*g[i];
+			const int den = 2*(u - i);
+			return (num >= 0) ? num / den : -((-num + den - 1) / den);
+		};
+
+		int q = 0;
+		S[0] = T[0] = 0;
+		for (int u = 1 ; u < width ; ++u)
+		{
+			while ((q >= 0) && (f(T[q], S[q]) > f(T[q], u))) --q;
+
+			if (q < 0)
 			{
-				fast_erase(ActiveSeaSideList, i--);									// we can throw it away as it will not generate min altitudes anymore
+				q = 0;
+				S[0] = u;
 			}
 			else
 			{
-				for (auto delta : { WalkPosition(d.x, d.y), WalkPosition(-d.x, d.y), WalkPosition(d.x, -d.y), WalkPosition(-d.x, -d.y),
-									WalkPosition(d.y, d.x), WalkPosition(-d.y, d.x), WalkPosition(d.y, -d.x), WalkPosition(-d.y, -d.x) })
+				const int t = 1 + sep(S[q], u);
+				if (t < width)
 				{
-					WalkPosition w = Current.origin + delta;
-					if (Valid(w))
-					{
-						auto & miniTile = GetMiniTile_(w, check_t::no_check);
-						if (miniTile.AltitudeMissing())
-						{
-							miniTile.SetAltitude(m_maxAltitude = Current.lastAltitudeGenerated = altitude);
-						}
-					}
+					++q;
+					S[q] = u;
+					T[q] = t;
 				}
 			}
 		}
+
+		for (int x = width - 1 ; x >= 0 ; --x)
+		{
+			const int squaredDist = f(x, S[q]);
+			if (x == T[q]) --q;
+
+			if ((x == 0) || (x == width - 1)) continue;
+
+			auto & miniTile = GetMiniTile_(WalkPosition(static_cast<float>(x - 1), static_cast<float>(y - 1)), check_t::no_check);
+			if (miniTile.AltitudeMissing())
+			{
+				const altitude_t altitude = altitude_t(0.5 + sqrt(double(squaredDist)) * altitude_scale);
+				miniTile.SetAltitude(altitude);
+				m_maxAltitude = max(m_maxAltitude, altitude);
+			}
+		}
 	}
 }
 
 
+// The searches of the doors only read the walkability, the lakes and the Neutrals, which step 4) does not modify.
+// So the candidates are independent: steps 1) to 3) are run for all of them in parallel, then step 4) is applied in order.
+// Each search marks its MiniTiles in a per thread VisitedGrid, whose stamps and FIFO are reused by all the searches of that thread.
+// As parallel_for starts new threads at each call, the grids of these threads are allocated at each call (once per thread, not per search).
 void MapImpl::ProcessBlockingNeutrals()
 {
 	vector<Neutral *> Candidates;
@@ -402,99 +708,119 @@ void MapImpl::ProcessBlockingNeutrals()
 		Candidates.push_back(m.get());
 	}
 
-	for (Neutral * pCandidate : Candidates)
+	const int width = static_cast<int>(WalkSize().x);
+	const int height = static_cast<int>(WalkSize().y);
+
+	// All the positions visited by a search are its start + integral offsets, so their integral parts identify their MiniTiles.
+	const auto index = [width](WalkPosition w) { return static_cast<int>(w.y) * width + static_cast<int>(w.x); };
+
+	vector<vector<WalkPosition>> TrueDoorsByCandidate(Candidates.size());
+	parallel_for(0, int(Candidates.size()), [&](int c)
 	{
-		if (!pCandidate->NextStacked())		// in the case where several neutrals are stacked, we only consider the top one
+		Neutral * pCandidate = Candidates[c];
+		if (pCandidate->NextStacked()) return;		// in the case where several neutrals are stacked, we only consider the top one
+
+		static thread_local utils::VisitedGrid<WalkPosition> Grid;
+
+		// 1)  Retreave the Border: the outer border of pCandidate
+		vector<WalkPosition> Border = outerMiniTileBorder(pCandidate->TopLeft(), pCandidate->Size());
+		really_remove_if(Border, [this](WalkPosition w) 
 		{
-			// 1)  Retreave the Border: the outer border of pCandidate
-			vector<WalkPosition> Border = outerMiniTileBorder(pCandidate->TopLeft(), pCandidate->Size());
-			really_remove_if(Border, [this](WalkPosition w) 
-			{
-				return !Valid(w) || !GetMiniTile(w, check_t::no_check).Walkable() ||
-					GetTile(TilePosition(w), check_t::no_check).GetNeutral(); });
+			return !Valid(w) || !GetMiniTile(w, check_t::no_check).Walkable() ||
+				GetTile(TilePosition(w), check_t::no_check).GetNeutral(); });
 
-			// 2)  Find the doors in Border: one door for each connected set of walkable, neighbouring miniTiles.
-			//     The searched connected miniTiles all have to be next to some lake or some static building, though they can't be part of one.
-			vector<WalkPosition> Doors;
-			while (!Border.empty())
+		// 2)  Find the doors in Border: one door for each connected set of walkable, neighbouring miniTiles.
+		//     The searched connected miniTiles all have to be next to some lake or some static building, though they can't be part of one.
+		vector<WalkPosition> Doors;
+		while (!Border.empty())
+		{
+			WalkPosition door = Border.back(); Border.pop_back();
+			Doors.push_back(door);
+
+			utils::VisitedGrid<WalkPosition>::Session session(Grid, width, height);
+			Grid.Push(door);
+			Grid.SetVisited(index(door));
+			while (!Grid.Empty())
 			{
-				WalkPosition door = Border.back(); Border.pop_back();
-				Doors.push_back(door);
-				vector<WalkPosition> ToVisit(1, door);
-				vector<WalkPosition> Visited(1, door);
-				while (!ToVisit.empty())
+				WalkPosition current = Grid.Pop();
+				for (WalkPosition delta : {WalkPosition(0, -1), WalkPosition(-1, 0), WalkPosition(+1, 0), WalkPosition(0, +1)})
 				{
-					WalkPosition current = ToVisit.back(); ToVisit.pop_back();
-					for (WalkPosition delta : {WalkPosition(0, -1), WalkPosition(-1, 0), WalkPosition(+1, 0), WalkPosition(0, +1)})
+					WalkPosition next = current + delta;
+					if (Valid(next) && !Grid.Visited(index(next)))
 					{
-						WalkPosition next = current + delta;
-						if (Valid(next) && !contains(Visited, next))
+						if (GetMiniTile(next, check_t::no_check).Walkable())
 						{
-							if (GetMiniTile(next, check_t::no_check).Walkable())
+							if (!GetTile(TilePosition(next), check_t::no_check).GetNeutral())
 							{
-								if (!GetTile(TilePosition(next), check_t::no_check).GetNeutral())
+								if (adjoins8SomeLakeOrNeutral(next, this))
 								{
-									if (adjoins8SomeLakeOrNeutral(next, this))
-									{
-										ToVisit.push_back(next);
-										Visited.push_back(next);
-									}
+									Grid.Push(next);
+									Grid.SetVisited(index(next));
 								}
 							}
 						}
 					}
 				}
-				really_remove_if(Border, [&Visited](WalkPosition w) { return contains(Visited, w); });
 			}
+			really_remove_if(Border, [&](WalkPosition w) { return Grid.Visited(index(w)); });
+		}
 
-			// 3)  If at least 2 doors, find the true doors in Border: a true door is a door that gives onto an area big enough
-			vector<WalkPosition> TrueDoors;
-			if (Doors.size() >= 2)
+		// 3)  If at least 2 doors, find the true doors in Border: a true door is a door that gives onto an area big enough
+		vector<WalkPosition> & TrueDoors = TrueDoorsByCandidate[c];
+		if (Doors.size() >= 2)
+		{
+			for (WalkPosition door : Doors)
 			{
-				for (WalkPosition door : Doors)
+				utils::VisitedGrid<WalkPosition>::Session session(Grid, width, height);
+				Grid.Push(door);
+				Grid.SetVisited(index(door));
+				size_t visited = 1;
+				const size_t limit = pCandidate->IsStaticBuilding() ? 10 : 400;
+				while (!Grid.Empty() && (visited < limit))
 				{
-					vector<WalkPosition> ToVisit(1, door);
-					vector<WalkPosition> Visited(1, door);
-					const size_t limit = pCandidate->IsStaticBuilding() ? 10 : 400;
-					while (!ToVisit.empty() && (Visited.size() < limit))
+					WalkPosition current = Grid.Pop();
+					for (WalkPosition delta : {WalkPosition(0, -1), WalkPosition(-1, 0), WalkPosition(+1, 0), WalkPosition(0, +1)})
 					{
-						WalkPosition current = ToVisit.back(); ToVisit.pop_back();
-						for (WalkPosition delta : {WalkPosition(0, -1), WalkPosition(-1, 0), WalkPosition(+1, 0), WalkPosition(0, +1)})
+						WalkPosition next = current + delta;
+						if (Valid(next) && !Grid.Visited(index(next)))
 						{
-							WalkPosition next = current + delta;
-							if (Valid(next) && !contains(Visited, next))
+							if (GetMiniTile(next, check_t::no_check).Walkable())
 							{
-								if (GetMiniTile(next, check_t::no_check).Walkable())
+								if (!GetTile(TilePosition(next), check_t::no_check).GetNeutral())
 								{
-									if (!GetTile(TilePosition(next), check_t::no_check).GetNeutral())
-									{
-										ToVisit.push_back(next);
-										Visited.push_back(next);
-									}
+									Grid.Push(next);
+									Grid.SetVisited(index(next));
+									++visited;
 								}
 							}
 						}
 					}
-					if (Visited.size() >= limit) TrueDoors.push_back(door);
 				}
+				if (visited >= limit) TrueDoors.push_back(door);
 			}
+		}
+	});
 
-			// 4)  If at least 2 true doors, pCandidate is a blocking static building
-			if (TrueDoors.size() >= 2)
-			{
-				// Marks pCandidate (and any Neutral stacked with it) as blocking.
-				for (Neutral * pNeutral = GetTile(pCandidate->TopLeft()).GetNeutral(); pNeutral; pNeutral = pNeutral->NextStacked())
-					pNeutral->SetBlocking(TrueDoors);
-
-				// Marks all the miniTiles of pCandidate as blocked.
-				// This way, areas at TrueDoors won't merge together.
-				for (int dy = 0; dy < WalkPosition(pCandidate->Size()).y; ++dy)
-					for (int dx = 0; dx < WalkPosition(pCandidate->Size()).x; ++dx)
-					{
-						auto & miniTile = GetMiniTile_(WalkPosition(pCandidate->TopLeft()) + WalkPosition(dx, dy));
-						if (miniTile.Walkable()) miniTile.SetBlocked();
-					}
-			}
+	for (size_t c = 0 ; c < Candidates.size() ; ++c)
+	{
+		Neutral * pCandidate = Candidates[c];
+		const vector<WalkPosition> & TrueDoors = TrueDoorsByCandidate[c];
+
+		// 4)  If at least 2 true doors, pCandidate is a blocking static building
+		if (TrueDoors.size() >= 2)
+		{
+			// Marks pCandidate (and any Neutral stacked with it) as blocking.
+			for (Neutral * pNeutral = GetTile(pCandidate->TopLeft()).GetNeutral(); pNeutral; pNeutral = pNeutral->NextStacked())
+				pNeutral->SetBlocking(TrueDoors);
+
+			// Marks all the miniTiles of pCandidate as blocked.
+			// This way, areas at TrueDoors won't merge together.
+			for (int dy = 0; dy < WalkPosition(pCandidate->Size()).y; ++dy)
+				for (int dx = 0; dx < WalkPosition(pCandidate->Size()).x; ++dx)
+				{
+					auto & miniTile = GetMiniTile_(WalkPosition(pCandidate->TopLeft()) + WalkPosition(dx, dy));
+					if (miniTile.Walkable()) miniTile.SetBlocked();
+				}
 		}
 	}
 }
@@ -505,6 +831,9 @@ void MapImpl::ProcessBlockingNeutrals()
 // A TempAreaInfo is not Valid() in two cases:
 //   - a default-constructed TempAreaInfo instance is never Valid (used as a dummy value to simplify the algorithm).
 //   - any other instance becomes invalid when absorbed (see Merge)
+// The TempAreaInfo instances also form a disjoint-set forest, indexed by their Id:
+// an absorbed TempAreaInfo points to the one that absorbed it (see Parent and findRoot).
+// This way, the MiniTiles and the frontier of an absorbed area need not be updated when merging.
 class TempAreaInfo
 {
 public:
@@ -513,6 +842,7 @@ public:
 							, m_id(0)
 							, m_top(0, 0)
 							, m_highestAltitude(0)
+							, m_parent(0)
 						{ 
 							bwem_assert(!Valid());
 						}
@@ -522,6 +852,7 @@ public:
 							, m_top(pos)
 							, m_size(0)
 							, m_highestAltitude(pMiniTile->Altitude())
+							, m_parent(id)
 														{ Add(pMiniTile); bwem_assert(Valid()); }
 
 	bool				Valid() const					{ return m_valid; }
@@ -530,14 +861,19 @@ public:
 	float					Size() const					{ bwem_assert(Valid()); return m_size; }
 	altitude_t			HighestAltitude() const			{ bwem_assert(Valid()); return m_highestAltitude; }
 
+	// Id() if Valid(), otherwise the Id of some TempAreaInfo this one was (directly or not) absorbed in.
+	Area::id			Parent() const					{ return m_parent; }
+	void				SetParent(Area::id id)			{ bwem_assert(!Valid()); m_parent = id; }
+
 	void				Add(MiniTile * pMiniTile)		{ bwem_assert(Valid()); ++m_size; pMiniTile->SetAreaId(m_id); }
 
-	// Left to caller : m.SetAreaId(this->Id()) for each MiniTile m in Absorbed
+	// The MiniTiles of Absorbed keep its Id, which findRoot maps to this->Id().
 	void				Merge(TempAreaInfo & Absorbed)	{
 															bwem_assert(Valid() && Absorbed.Valid());
 															bwem_assert(m_size >= Absorbed.m_size);
 															m_size += Absorbed.m_size;
 															Absorbed.m_valid = false;
+															Absorbed.m_parent = m_id;
 														}
 
 	TempAreaInfo &		operator=(const TempAreaInfo &) = delete;
@@ -548,9 +884,26 @@ private:
 	const WalkPosition	m_top;
 	const altitude_t	m_highestAltitude;
 	int					m_size;
+	Area::id			m_parent;
 };
 
 
+// Returns the Id of the valid TempAreaInfo that absorbed (directly or not) the area id, or id itself if it is still valid.
+// Uses path halving, so that the chains of absorptions remain short.
+static Area::id findRoot(vector<TempAreaInfo> & TempAreaList, Area::id id)
+{
+	while (TempAreaList[id].Parent() != id)
+	{
+		const Area::id parent = TempAreaList[id].Parent();
+		const Area::id grandParent = TempAreaList[parent].Parent();
+		if (grandParent != parent) TempAreaList[id].SetParent(grandParent);
+		id = grandParent;
+	}
+
+	return id;
+}
+
+
 // Assigns MiniTile::m_areaId for each miniTile having AreaIdMissing()
 // Areas are computed using MiniTile::Altitude() information only.
 // The miniTiles are considered successively in descending order of their Altitude().
@@ -560,7 +913,7 @@ private:
 //   - makes two neighbouring areas merge together.
 void MapImpl::ComputeAreas()
 {
-	vector<pair<WalkPosition, MiniTile *>> MiniTilesByDescendingAltitude = SortMiniTiles();
+	vector<int> MiniTilesByDescendingAltitude = SortMiniTiles();
 
 	vector<TempAreaInfo> TempAreaList = ComputeTempAreas(MiniTilesByDescendingAltitude);
 
@@ -570,36 +923,46 @@ void MapImpl::ComputeAreas()
 }
 
 
-vector<pair<WalkPosition, MiniTile *>> MapImpl::SortMiniTiles()
+// Returns the indexes (in m_MiniTiles) of the MiniTiles having AreaIdMissing(), in descending order of their Altitude().
+// Altitudes are bounded by m_maxAltitude, so a counting sort is used.
+// It is stable: MiniTiles with the same Altitude() are ordered by y, then x, which keeps the Area ids deterministic.
+vector<int> MapImpl::SortMiniTiles() const
 {
-	vector<pair<WalkPosition, MiniTile *>> MiniTilesByDescendingAltitude;
-	for (int y = 0 ; y < WalkSize().y ; ++y)
-	for (int x = 0 ; x < WalkSize().x ; ++x)
-	{
-		WalkPosition w = WalkPosition(x, y);
-		MiniTile & miniTile = GetMiniTile_(w, check_t::no_check);
+	vector<int> Count(m_maxAltitude + 2, 0);		// Count[m_maxAltitude - altitude + 1] : number of MiniTiles with this altitude
+	int n = 0;
+	for (const MiniTile & miniTile : m_MiniTiles)
 		if (miniTile.AreaIdMissing())
-			MiniTilesByDescendingAltitude.emplace_back(w, &miniTile);
-	}
+		{
+			bwem_assert((0 <= miniTile.Altitude()) && (miniTile.Altitude() <= m_maxAltitude));
+			++Count[m_maxAltitude - miniTile.Altitude() + 1];
+			++n;
+		}
 
-	sort(MiniTilesByDescendingAltitude.begin(), MiniTilesByDescendingAltitude.end(),
-		[](const pair<WalkPosition, MiniTile *> & a, const pair<WalkPosition, MiniTile *> & b){ return a.second->Altitude() > b.second->Altitude(); });
+	// Count[m_maxAltitude - altitude] becomes the first index for this altitude:
+	for (size_t i = 1 ; i < Count.size() ; ++i)
+		Count[i] += Count[i-1];
+
+	vector<int> MiniTilesByDescendingAltitude(n);
+	for (int i = 0 ; i < (int)m_MiniTiles.size() ; ++i)
+		if (m_MiniTiles[i].AreaIdMissing())
+			MiniTilesByDescendingAltitude[Count[m_maxAltitude - m_MiniTiles[i].Altitude()]++] = i;
 
 	return MiniTilesByDescendingAltitude;
 }
 
 
-static pair<Area::id, Area::id> findNeighboringAreas(WalkPosition p, const MapImpl * pMap)
+static pair<Area::id, Area::id> findNeighboringAreas(WalkCoord p, const MapImpl * pMap, vector<TempAreaInfo> & TempAreaList)
 {
 	pair<Area::id, Area::id> result(0, 0);
 
-	for (WalkPosition delta : {WalkPosition(0, -1), WalkPosition(-1, 0), WalkPosition(+1, 0), WalkPosition(0, +1)})
+	for (WalkCoord delta : {WalkCoord(0, -1), WalkCoord(-1, 0), WalkCoord(+1, 0), WalkCoord(0, +1)})
 	{
 		if (pMap->Valid(p + delta))
 		{
 			Area::id areaId = pMap->GetMiniTile(p + delta, check_t::no_check).AreaId();
 			if (areaId > 0)
 			{
+				areaId = findRoot(TempAreaList, areaId);
 				if (!result.first)
 				{
 					result.first = areaId;
@@ -630,15 +993,18 @@ static Area::id chooseNeighboringArea(Area::id a, Area::id b)
 }
 
 
-vector<TempAreaInfo> MapImpl::ComputeTempAreas(const vector<pair<WalkPosition, MiniTile *>> & MiniTilesByDescendingAltitude)
+vector<TempAreaInfo> MapImpl::ComputeTempAreas(const vector<int> & MiniTilesByDescendingAltitude)
 {
+	const int width = static_cast<int>(WalkSize().x);
+
 	vector<TempAreaInfo> TempAreaList(1);		// TempAreaList[0] left unused, as AreaIds are > 0
-	for (const auto & Current : MiniTilesByDescendingAltitude)
+	for (int index : MiniTilesByDescendingAltitude)
 	{
-		const WalkPosition pos = Current.first;
-		MiniTile * cur = Current.second;
+		const WalkCoord coord(index % width, index / width);
+		const WalkPosition pos(coord);
+		MiniTile * cur = &m_MiniTiles[index];
 		
-		pair<Area::id, Area::id> neighboringAreas = findNeighboringAreas(pos, this);
+		pair<Area::id, Area::id> neighboringAreas = findNeighboringAreas(coord, this, TempAreaList);
 		if (!neighboringAreas.first)			// no neighboring area : creates of a new area
 		{
 			TempAreaList.emplace_back((Area::id)TempAreaList.size(), cur, pos);
@@ -667,20 +1033,26 @@ vector<TempAreaInfo> MapImpl::ComputeTempAreas(const vector<pair<WalkPosition, M
 				TempAreaList[bigger].Add(cur);
 
 				// merges the two neighboring areas:
-				ReplaceAreaIds(TempAreaList[smaller].Top(), bigger);
 				TempAreaList[bigger].Merge(TempAreaList[smaller]);
 			}
 			else	// no merge : cur starts or continues the frontier between the two neighboring areas
 			{
 				// adds cur to the chosen Area:
 				TempAreaList[chooseNeighboringArea(smaller, bigger)].Add(cur);
-				m_RawFrontier.emplace_back(neighboringAreas, pos);
+				m_RawFrontier.emplace_back(neighboringAreas, coord);
 			}
 		}	
 	}
 
+	// Replaces the absorbed areas in the frontier by the ones that absorbed them:
+	for (auto & f : m_RawFrontier)
+	{
+		f.first.first = findRoot(TempAreaList, f.first.first);
+		f.first.second = findRoot(TempAreaList, f.first.second);
+	}
+
 	// Remove from the frontier obsolete positions
-	really_remove_if(m_RawFrontier, [](const pair<pair<Area::id, Area::id>, Sc2Bindings::WalkPosition> & f)
+	really_remove_if(m_RawFrontier, [](const pair<pair<Area::id, Area::id>, Sc2Bindings::WalkCoord> & f)
 		{ return f.first.first == f.first.second; });
 
 	return TempAreaList;
@@ -688,7 +1060,8 @@ vector<TempAreaInfo> MapImpl::ComputeTempAreas(const vector<pair<WalkPosition, M
 
 
 // Initializes m_Graph with the valid and big enough areas in TempAreaList.
-void MapImpl::CreateAreas(const vector<TempAreaInfo> & TempAreaList)
+// The MiniTiles still hold the temporary ids, possibly of absorbed areas: they are all relabeled here, in one pass.
+void MapImpl::CreateAreas(vector<TempAreaInfo> & TempAreaList)
 {
 	typedef pair<WalkPosition, int>	pair_top_size_t;
 	vector<pair_top_size_t> AreasList;
@@ -696,27 +1069,43 @@ void MapImpl::CreateAreas(const vector<TempAreaInfo> & TempAreaList)
 	Area::id newAreaId = 1;
 	Area::id newTinyAreaId = -2;
 
+	// FinalId[id] : the final id of the valid TempAreaInfo id.
+	vector<Area::id> FinalId(TempAreaList.size(), 0);
 	for (auto & TempArea : TempAreaList)
 		if (TempArea.Valid())
 		{
 			if (TempArea.Size() >= area_min_miniTiles)
 			{
 				bwem_assert(newAreaId <= TempArea.Id());
-				if (newAreaId != TempArea.Id())
-				{
-					ReplaceAreaIds(TempArea.Top(), newAreaId);
-				}
+				FinalId[TempArea.Id()] = newAreaId;
 
 				AreasList.emplace_back(TempArea.Top(), TempArea.Size());
 				newAreaId++;
 			}
 			else
 			{
-				ReplaceAreaIds(TempArea.Top(), newTinyAreaId);
+				FinalId[TempArea.Id()] = newTinyAreaId;
 				newTinyAreaId--;
 			}
 		}
 
+	for (Area::id id = 1 ; id < (Area::id)TempAreaList.size() ; ++id)
+		FinalId[id] = FinalId[findRoot(TempAreaList, id)];
+
+	for (MiniTile & miniTile : m_MiniTiles)
+		if (miniTile.AreaId() > 0)
+		{
+			const Area::id id = FinalId[miniTile.AreaId()];
+			if (id != miniTile.AreaId()) miniTile.ReplaceAreaId(id);
+		}
+
+	// The frontier only refers to the areas that are not tiny:
+	for (auto & f : m_RawFrontier)
+	{
+		if (FinalId[f.first.first] > 0) f.first.first = FinalId[f.first.first];
+		if (FinalId[f.first.second] > 0) f.first.second = FinalId[f.first.second];
+	}
+
 	GetGraph().CreateAreas(AreasList);
 }
 
@@ -742,10 +1131,11 @@ void MapImpl::SetAltitudeInTile(TilePosition t)
 {
 	altitude_t minAltitude = numeric_limits<altitude_t>::max();
 
+	const WalkCoord origin = WalkCoord(WalkPosition(t));
 	for (int dy = 0 ; dy < 4 ; ++dy)
 	for (int dx = 0 ; dx < 4 ; ++dx)
 	{
-		altitude_t altitude = GetMiniTile(WalkPosition(t) + WalkPosition(dx, dy), check_t::no_check).Altitude();
+		altitude_t altitude = GetMiniTile(origin + WalkCoord(dx, dy), check_t::no_check).Altitude();
 		if (altitude < minAltitude)	minAltitude = altitude;
 	}
 
@@ -779,12 +1169,135 @@ Geyser * MapImpl::GetGeyser(sc2::Unit u) const
 }
 
 
+// Builds the summed-area tables of the rectangle queries (Cf. Map::BuildableTileCount).
+void MapImpl::ComputeSummedAreaTables()
+{
+	m_WalkableMiniTileSums.Build(0, 0, m_walkWidth, m_walkHeight,
+		[this](int x, int y) { return GetMiniTile(WalkCoord(x, y), check_t::no_check).Walkable() ? 1 : 0; });
+
+	const int width = static_cast<int>(Size().x);
+	const int height = static_cast<int>(Size().y);
+	m_BuildableTileSums.Build(0, 0, width, height, [this, width](int x, int y) { return m_Tiles[y * width + x].Buildable() ? 1 : 0; });
+
+	ComputeNeutralTileSums();
+	ComputeAreaTileSums();
+}
+
+
+// The destruction of any Neutral modifies this table (Cf. OnMineralDestroyed and OnStaticBuildingDestroyed).
+void MapImpl::ComputeNeutralTileSums()
+{
+	const int width = static_cast<int>(Size().x);
+	const int height = static_cast<int>(Size().y);
+	m_NeutralTileSums.Build(0, 0, width, height, [this, width](int x, int y) { return m_Tiles[y * width + x].GetNeutral() ? 1 : 0; });
+}
+
+
+// Builds the table of each Area over its bounding box.
+void MapImpl::ComputeAreaTileSums()
+{
+	const int width = static_cast<int>(Size().x);
+	const int height = static_cast<int>(Size().y);
+	const auto tile = [this, width](int x, int y) -> const Tile & { return m_Tiles[y * width + x]; };
+
+	const int areasCount = GetGraph().AreasCount();
+	vector<pair<TileCoord, TileCoord>> BoundingBoxes(areasCount, make_pair(TileCoord(int16_t(width), int16_t(height)), TileCoord(-1, -1)));
+	for (int y = 0 ; y < height ; ++y)
+	for (int x = 0 ; x < width ; ++x)
+	{
+		const Area::id id = tile(x, y).AreaId();
+		if (id <= 0) continue;
+
+		auto & Box = BoundingBoxes[id - 1];
+		Box.first.x = min(Box.first.x, int16_t(x));
+		Box.first.y = min(Box.first.y, int16_t(y));
+		Box.second.x = max(Box.second.x, int16_t(x));
+		Box.second.y = max(Box.second.y, int16_t(y));
+	}
+
+	m_AreaTileSums.resize(areasCount);
+	for (int i = 0 ; i < areasCount ; ++i)
+	{
+		const TileCoord topLeft = BoundingBoxes[i].first;
+		const TileCoord bottomRight = BoundingBoxes[i].second;
+		const Area::id id = Area::id(i + 1);
+		m_AreaTileSums[i].Build(topLeft.x, topLeft.y, max(bottomRight.x - topLeft.x + 1, 0), max(bottomRight.y - topLeft.y + 1, 0),
+			[&tile, id](int x, int y) { return (tile(x, y).AreaId() == id) ? 1 : 0; });
+	}
+}
+
+
+// Only the destruction of a blocking Neutral modifies the Areas of some Tiles (ChangedTiles).
+// ChangedAreas are the Areas these Tiles belonged to before. Only the tables of these Areas and of the new ones are rebuilt,
+// over their bounding boxes extended to ChangedTiles.
+void MapImpl::UpdateAreaTileSums(const vector<TileCoord> & ChangedTiles, vector<Area::id> ChangedAreas)
+{
+	if (ChangedTiles.empty()) return;
+
+	const int width = static_cast<int>(Size().x);
+	const auto tile = [this, width](int x, int y) -> const Tile & { return m_Tiles[y * width + x]; };
+
+	TileCoord topLeft = ChangedTiles.front();
+	TileCoord bottomRight = ChangedTiles.front();
+	for (const TileCoord & t : ChangedTiles)
+	{
+		makeBoundingBoxIncludePoint(topLeft, bottomRight, t);
+		ChangedAreas.push_back(tile(t.x, t.y).AreaId());
+	}
+
+	sort(ChangedAreas.begin(), ChangedAreas.end());
+	ChangedAreas.erase(unique(ChangedAreas.begin(), ChangedAreas.end()), ChangedAreas.end());
+	for (Area::id id : ChangedAreas)
+	{
+		if (id <= 0) continue;
+
+		utils::IntegralGrid & Sums = m_AreaTileSums[id - 1];
+		TileCoord boxTopLeft = topLeft;
+		TileCoord boxBottomRight = bottomRight;
+		if ((Sums.Width() > 0) && (Sums.Height() > 0))
+		{
+			makeBoundingBoxIncludePoint(boxTopLeft, boxBottomRight, TileCoord(int16_t(Sums.Left()), int16_t(Sums.Top())));
+			makeBoundingBoxIncludePoint(boxTopLeft, boxBottomRight, TileCoord(int16_t(Sums.Left() + Sums.Width() - 1), int16_t(Sums.Top() + Sums.Height() - 1)));
+		}
+
+		Sums.Build(boxTopLeft.x, boxTopLeft.y, boxBottomRight.x - boxTopLeft.x + 1, boxBottomRight.y - boxTopLeft.y + 1,
+			[&tile, id](int x, int y) { return (tile(x, y).AreaId() == id) ? 1 : 0; });
+	}
+}
+
+
+int MapImpl::BuildableTileCount(TileCoord topLeft, TileCoord size) const
+{
+	return m_BuildableTileSums.Sum(topLeft.x, topLeft.y, size.x, size.y);
+}
+
+
+int MapImpl::NeutralTileCount(TileCoord topLeft, TileCoord size) const
+{
+	return m_NeutralTileSums.Sum(topLeft.x, topLeft.y, size.x, size.y);
+}
+
+
+int MapImpl::AreaTileCount(const Area * pArea, TileCoord topLeft, TileCoord size) const
+{
+	bwem_assert(pArea && (pArea->Id() >= 1) && (pArea->Id() <= int(m_AreaTileSums.size())));
+	return m_AreaTileSums[pArea->Id() - 1].Sum(topLeft.x, topLeft.y, size.x, size.y);
+}
+
+
+int MapImpl::WalkableMiniTileCount(WalkCoord topLeft, WalkCoord size) const
+{
+	return m_WalkableMiniTileSums.Sum(topLeft.x, topLeft.y, size.x, size.y);
+}
+
+
 void MapImpl::OnMineralDestroyed(sc2::Unit u)
 {
 	auto iMineral = find_if(m_Minerals.begin(), m_Minerals.end(), [u](const unique_ptr<Mineral> & m){ return m->GetUnit().tag == u.tag; });
 	bwem_assert(iMineral != m_Minerals.end());
 
 	fast_erase(m_Minerals, distance(m_Minerals.begin(), iMineral));
+	ComputeNeutralTileSums();
 }
 
 
@@ -794,6 +1307,7 @@ void MapImpl::OnStaticBuildingDestroyed(sc2::Unit u)
 	bwem_assert(iStaticBuilding != m_StaticBuildings.end());
 
 	fast_erase(m_StaticBuildings, distance(m_StaticBuildings.begin(), iStaticBuilding));
+	ComputeNeutralTileSums();
 }
 
 
@@ -808,9 +1322,15 @@ void MapImpl::OnBlockingNeutralDestroyed(const Neutral * pBlocking)
 {
 	bwem_assert(pBlocking && pBlocking->Blocking());
 
+	vector<const ChokePoint *> UnblockedChokePoints;
 	for (const Area * pArea : pBlocking->BlockedAreas())
 		for (const ChokePoint * cp : pArea->ChokePoints())
+		{
+			const bool wasBlocked = cp->Blocked();
 			const_cast<ChokePoint *>(cp)->OnBlockingNeutralDestroyed(pBlocking);
+			if (wasBlocked && !cp->Blocked() && !contains(UnblockedChokePoints, cp))
+				UnblockedChokePoints.push_back(cp);
+		}
 
 	if (GetTile(pBlocking->TopLeft()).GetNeutral()) return;		// there remains some blocking Neutrals at the same location
 
@@ -824,15 +1344,32 @@ void MapImpl::OnBlockingNeutralDestroyed(const Neutral * pBlocking)
 	}
 
 	// Unblock the Tiles of pBlocking:
+	vector<TileCoord> ChangedTiles;
+	vector<Area::id> OldAreaIds;
 	for (int dy = 0 ; dy < pBlocking->Size().y ; ++dy)
 	for (int dx = 0 ; dx < pBlocking->Size().x ; ++dx)
 	{
-		GetTile_(pBlocking->TopLeft() + TilePosition(dx, dy)).ResetAreaId();
+		Tile & tile = GetTile_(pBlocking->TopLeft() + TilePosition(dx, dy));
+		OldAreaIds.push_back(tile.AreaId());
+		tile.ResetAreaId();
 		SetAreaIdInTile(pBlocking->TopLeft() + TilePosition(dx, dy));
+
+		const int i = int(&tile - m_Tiles.data());		// TopLeft() may not be integral: records the Tile actually updated
+		ChangedTiles.emplace_back(int16_t(i % int(Size().x)), int16_t(i / int(Size().x)));
 	}
 
+	UpdateAreaTileSums(ChangedTiles, move(OldAreaIds));
+
 	if (AutomaticPathUpdate())
-		GetGraph().ComputeChokePointDistanceMatrix();
+	{
+		GetGraph().UpdateChokePointDistanceMatrix(ChangedTiles, UnblockedChokePoints);
+		GetGraph().UpdateLandmarks(ChangedTiles);		// the walkable Tiles have changed
+	}
+	else
+	{
+		GetGraph().InvalidateChokePointDistanceMatrix();
+		GetGraph().ClearLandmarks();		// they would no longer give lower bounds of the ground distances
+	}
 }
 
 
@@ -59,6 +59,10 @@ namespace SC2EM {
 			~MapImpl();
 
 			void						Initialize(const ObservationInterface *obs) override;
+			void						Initialize(const MapSource & source) override;
+			void						Initialize(const MapSource & source, const std::string & cacheFileName) override;
+			bool						InitializedFromCache() const override { return m_initializedFromCache; }
+			const InitializationStats &	GetInitializationStats() const override { return m_InitializationStats; }
 
 			bool						AutomaticPathUpdate() const override { return m_automaticPathUpdate; }
 			void						EnableAutomaticPathAnalysis() const override { m_automaticPathUpdate = true; }
@@ -82,6 +86,11 @@ namespace SC2EM {
 			void						OnMineralDestroyed(sc2::Unit u) override;
 			void						OnStaticBuildingDestroyed(sc2::Unit u) override;
 
+			int							BuildableTileCount(Sc2Bindings::TileCoord topLeft, Sc2Bindings::TileCoord size) const override;
+			int							NeutralTileCount(Sc2Bindings::TileCoord topLeft, Sc2Bindings::TileCoord size) const override;
+			int							AreaTileCount(const Area * pArea, Sc2Bindings::TileCoord topLeft, Sc2Bindings::TileCoord size) const override;
+			int							WalkableMiniTileCount(Sc2Bindings::WalkCoord topLeft, Sc2Bindings::WalkCoord size) const override;
+
 			const vector<Area> &		Areas() const override { return GetGraph().Areas(); }
 
 			// Returns an Area given its id. Range = 1..Size()
@@ -101,13 +110,18 @@ namespace SC2EM {
 			Area *						GetNearestArea(Sc2Bindings::TilePosition t) { return m_Graph.GetNearestArea(t); }
 
 
-			const CPPath &				GetPath(const Sc2Bindings::Position & a, const Sc2Bindings::Position & b, int * pLength = nullptr) const override { return m_Graph.GetPath(a, b, pLength); }
+			CPPath						GetPath(const Sc2Bindings::Position & a, const Sc2Bindings::Position & b, int * pLength = nullptr) const override { return m_Graph.GetPath(a, b, pLength); }
+			void						GetPaths(utils::Span<const Sc2Bindings::Position> From, utils::Span<const Sc2Bindings::Position> To,
+												utils::Span<CPPath> Paths, utils::Span<int> Lengths = utils::Span<int>()) const override
+											{ m_Graph.GetPaths(From, To, Paths, Lengths); }
+			int							GetGroundDistance(const Sc2Bindings::Position & a, const Sc2Bindings::Position & b) const override { return m_Graph.GetGroundDistance(a, b); }
+			int							GetTilePath(const Sc2Bindings::Position & a, const Sc2Bindings::Position & b, TilePath & Path) const override { return m_Graph.GetTilePath(a, b, Path); }
 
 			const class Graph &			GetGraph() const { return m_Graph; }
 			class Graph &				GetGraph() { return m_Graph; }
 
 
-			const vector<pair<pair<Area::id, Area::id>, Sc2Bindings::WalkPosition>> &		RawFrontier() const override { return m_RawFrontier; }
+			const vector<pair<pair<Area::id, Area::id>, Sc2Bindings::WalkCoord>> &		RawFrontier() const override { return m_RawFrontier; }
 
 
 
@@ -115,26 +129,36 @@ namespace SC2EM {
 			void						OnBlockingNeutralDestroyed(const Neutral * pBlocking);
 
 		private:
-			void						ReplaceAreaIds(Sc2Bindings::WalkPosition p, Area::id newAreaId);
-
-			void						InitializeNeutrals(const ObservationInterface *obs);
-			void						LoadData(const ObservationInterface *obs);
+			void						Reset(const MapSource & source);
+			bool						LoadCache(const MapSource & source, const utils::BitGrid & Pathable, const utils::BitGrid & Placable,
+												uint64_t key, const std::string & fileName);
+			void						SaveCache(uint64_t key, const std::string & fileName) const;
+			static uint64_t				SourceKey(const MapSource & source, const utils::BitGrid & Pathable, const utils::BitGrid & Placable);
+			vector<Neutral *>			CanonicalNeutrals() const;
+
+			void						InitializeNeutrals(const MapSource & source);
+			void						LoadData(const MapSource & source, const utils::BitGrid & Pathable, const utils::BitGrid & Placable);
 			void						DecideSeasOrLakes();
 			void						ComputeAltitude();
 			void						ProcessBlockingNeutrals();
 			void						ComputeAreas();
-			vector<pair<Sc2Bindings::WalkPosition, MiniTile *>>
-				SortMiniTiles();
-			vector<TempAreaInfo>		ComputeTempAreas(const vector<pair<Sc2Bindings::WalkPosition, MiniTile *>> & MiniTilesByDescendingAltitude);
-			void						CreateAreas(const vector<TempAreaInfo> & TempAreaList);
+			vector<int>					SortMiniTiles() const;
+			vector<TempAreaInfo>		ComputeTempAreas(const vector<int> & MiniTilesByDescendingAltitude);
+			void						CreateAreas(vector<TempAreaInfo> & TempAreaList);
 			void						SetAreaIdInTiles();
 			void						SetAreaIdInTile(Sc2Bindings::TilePosition t);
 			void						SetAltitudeInTile(Sc2Bindings::TilePosition t);
+			void						ComputeSummedAreaTables();
+			void						ComputeNeutralTileSums();
+			void						ComputeAreaTileSums();
+			void						UpdateAreaTileSums(const vector<Sc2Bindings::TileCoord> & ChangedTiles, vector<Area::id> ChangedAreas);
 
 
 			altitude_t							m_maxAltitude;
 
 			mutable bool						m_automaticPathUpdate = false;
+			bool								m_initializedFromCache = false;
+			InitializationStats					m_InitializationStats;
 
 			class Graph							m_Graph;
 			vector<unique_ptr<Mineral>>			m_Minerals;
@@ -142,7 +166,13 @@ namespace SC2EM {
 			vector<unique_ptr<StaticBuilding>>	m_StaticBuildings;
 			vector<Sc2Bindings::TilePosition>			m_StartingLocations;
 
-			vector<pair<pair<Area::id, Area::id>, Sc2Bindings::WalkPosition>>	m_RawFrontier;
+			vector<pair<pair<Area::id, Area::id>, Sc2Bindings::WalkCoord>>	m_RawFrontier;
+
+			// Cf. Map::BuildableTileCount and the other rectangle queries:
+			utils::IntegralGrid					m_BuildableTileSums;
+			utils::IntegralGrid					m_NeutralTileSums;
+			vector<utils::IntegralGrid>			m_AreaTileSums;				// index == Area::id - 1, each one over the bounding box of its Area
+			utils::IntegralGrid					m_WalkableMiniTileSums;
 		};
 
 
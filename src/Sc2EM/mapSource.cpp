@@ -0,0 +1,312 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is part of the BWEM Library.
+// BWEM is free software, licensed under the MIT/X11 License.
+// A copy of the license is provided with the library in the LICENSE file.
+// Copyright (c) 2015, 2017, Igor Dimitrijevic
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#include "mapSource.h"
+#include <fstream>
+#include <cstring>
+#include <cmath>
+
+
+using namespace Sc2Bindings;
+
+using namespace std;
+
+
+namespace SC2EM {
+
+
+static const char snapshotMagic[8] = { 'S', 'C', '2', 'E', 'M', 'M', 'A', 'P' };
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class MapSource
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+void MapSource::ReadGrids(utils::BitGrid & Pathable, utils::BitGrid & Placable) const
+{
+	bwem_assert((Pathable.Width() == Placable.Width()) && (Pathable.Height() == Placable.Height()));
+
+	for (int y = 0 ; y < Pathable.Height() ; ++y)
+	for (int x = 0 ; x < Pathable.Width() ; ++x)
+	{
+		const sc2::Point2D p(static_cast<float>(x), static_cast<float>(y));
+		if (IsPathable(p)) Pathable.Set(x, y);
+		if (IsPlacable(p)) Placable.Set(x, y);
+	}
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class ObservationMapSource
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+TilePosition ObservationMapSource::Size() const
+{
+	return TilePositionFromPoint2D(m_obs->GetGameInfo().playable_max);
+}
+
+
+vector<sc2::Point2D> ObservationMapSource::StartLocations() const
+{
+	return m_obs->GetGameInfo().start_locations;
+}
+
+
+vector<sc2::Unit> ObservationMapSource::NeutralUnits() const
+{
+	vector<sc2::Unit> Units;
+	for (const sc2::Unit * u : m_obs->GetUnits(sc2::Unit::Alliance::Neutral))
+		Units.push_back(*u);
+
+	return Units;
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class SnapshotMapSource
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+// Little-endian encoding helpers, so that snapshots can be exchanged between machines.
+
+static void writeU32(ostream & out, uint32_t v)
+{
+	const char bytes[4] = { char(v), char(v >> 8), char(v >> 16), char(v >> 24) };
+	out.write(bytes, 4);
+}
+
+
+static void writeU64(ostream & out, uint64_t v)
+{
+	writeU32(out, uint32_t(v));
+	writeU32(out, uint32_t(v >> 32));
+}
+
+
+static void writeI32(ostream & out, int32_t v)
+{
+	writeU32(out, static_cast<uint32_t>(v));
+}
+
+
+static void writeFloat(ostream & out, float v)
+{
+	uint32_t bits;
+	memcpy(&bits, &v, sizeof(bits));
+	writeU32(out, bits);
+}
+
+
+static uint32_t readU32(istream & in)
+{
+	unsigned char bytes[4];
+	if (!in.read(reinterpret_cast<char *>(bytes), 4)) throw Exception("SnapshotMapSource: unexpected end of file");
+
+	return uint32_t(bytes[0]) | (uint32_t(bytes[1]) << 8) | (uint32_t(bytes[2]) << 16) | (uint32_t(bytes[3]) << 24);
+}
+
+
+static uint64_t readU64(istream & in)
+{
+	const uint64_t low = readU32(in);
+	return low | (uint64_t(readU32(in)) << 32);
+}
+
+
+static int32_t readI32(istream & in)
+{
+	return static_cast<int32_t>(readU32(in));
+}
+
+
+static float readFloat(istream & in)
+{
+	const uint32_t bits = readU32(in);
+	float v;
+	memcpy(&v, &bits, sizeof(v));
+	return v;
+}
+
+
+static int gridIndex(const sc2::Point2D & p, int width, int height)
+{
+	const int x = static_cast<int>(floor(p.x));
+	const int y = static_cast<int>(floor(p.y));
+	return (0 <= x) && (x < width) && (0 <= y) && (y < height) ? y * width + x : -1;
+}
+
+
+SnapshotMapSource::SnapshotMapSource(const string & fileName)
+{
+	ifstream in(fileName, ios::binary);
+	if (!in) throw Exception("SnapshotMapSource: could not open " + fileName);
+
+	char magic[sizeof(snapshotMagic)];
+	if (!in.read(magic, sizeof(magic)) || memcmp(magic, snapshotMagic, sizeof(magic)) != 0)
+		throw Exception("SnapshotMapSource: " + fileName + " is not a terrain snapshot");
+
+	if (readU32(in) != version) throw Exception("SnapshotMapSource: unsupported version in " + fileName);
+
+	m_width = readI32(in);
+	m_height = readI32(in);
+	if ((m_width <= 0) || (m_height <= 0) || (m_width > 1024) || (m_height > 1024))
+		throw Exception("SnapshotMapSource: invalid map size in " + fileName);
+
+	for (uint32_t n = readU32(in) ; n ; --n)
+	{
+		const float x = readFloat(in);
+		const float y = readFloat(in);
+		m_StartLocations.emplace_back(x, y);
+	}
+
+	const int walkWidth = 4*m_width;
+	const int walkHeight = 4*m_height;
+	vector<uint8_t> Plane((size_t(walkWidth) * size_t(walkHeight) + 7) / 8);
+	for (utils::BitGrid * pGrid : { &m_Pathable, &m_Placable })
+	{
+		if (!in.read(reinterpret_cast<char *>(Plane.data()), Plane.size())) throw Exception("SnapshotMapSource: unexpected end of file");
+
+		*pGrid = utils::BitGrid(walkWidth, walkHeight);
+		for (int y = 0 ; y < walkHeight ; ++y)
+		for (int x = 0 ; x < walkWidth ; ++x)
+		{
+			const size_t i = size_t(y) * walkWidth + x;
+			if (Plane[i / 8] & (1 << (i % 8))) pGrid->Set(x, y);
+		}
+	}
+
+	m_Heights.resize(size_t(m_width) * size_t(m_height));
+	for (float & h : m_Heights)
+		h = readFloat(in);
+
+	for (uint32_t n = readU32(in) ; n ; --n)
+	{
+		sc2::Unit u;
+		u.tag = readU64(in);
+		u.unit_type = sc2::UnitTypeID(static_cast<sc2::UNIT_TYPEID>(readU32(in)));
+		u.pos.x = readFloat(in);
+		u.pos.y = readFloat(in);
+		u.pos.z = readFloat(in);
+		u.radius = readFloat(in);
+		u.mineral_contents = readI32(in);
+		u.vespene_contents = readI32(in);
+		u.alliance = sc2::Unit::Alliance::Neutral;
+		m_NeutralUnits.push_back(u);
+	}
+}
+
+
+void SnapshotMapSource::Save(const MapSource & source, const string & fileName)
+{
+	ofstream out(fileName, ios::binary | ios::trunc);
+	if (!out) throw Exception("SnapshotMapSource: could not create " + fileName);
+
+	const int width = static_cast<int>(source.Size().x);
+	const int height = static_cast<int>(source.Size().y);
+
+	out.write(snapshotMagic, sizeof(snapshotMagic));
+	writeU32(out, version);
+	writeI32(out, width);
+	writeI32(out, height);
+
+	const vector<sc2::Point2D> StartLocations = source.StartLocations();
+	writeU32(out, uint32_t(StartLocations.size()));
+	for (const sc2::Point2D & p : StartLocations)
+	{
+		writeFloat(out, p.x);
+		writeFloat(out, p.y);
+	}
+
+	const int walkWidth = 4*width;
+	const int walkHeight = 4*height;
+	utils::BitGrid PathableGrid(walkWidth, walkHeight);
+	utils::BitGrid PlacableGrid(walkWidth, walkHeight);
+	source.ReadGrids(PathableGrid, PlacableGrid);
+
+	vector<uint8_t> Pathable((size_t(walkWidth) * size_t(walkHeight) + 7) / 8, 0);
+	vector<uint8_t> Placable(Pathable.size(), 0);
+	for (int y = 0 ; y < walkHeight ; ++y)
+	for (int x = 0 ; x < walkWidth ; ++x)
+	{
+		const size_t i = size_t(y) * walkWidth + x;
+		if (PathableGrid.Get(x, y)) Pathable[i / 8] |= uint8_t(1 << (i % 8));
+		if (PlacableGrid.Get(x, y)) Placable[i / 8] |= uint8_t(1 << (i % 8));
+	}
+	out.write(reinterpret_cast<const char *>(Pathable.data()), Pathable.size());
+	out.write(reinterpret_cast<const char *>(Placable.data()), Placable.size());
+
+	for (int y = 0 ; y < height ; ++y)
+	for (int x = 0 ; x < width ; ++x)
+		writeFloat(out, source.TerrainHeight(sc2::Point2D(static_cast<float>(x), static_cast<float>(y))));
+
+	const vector<sc2::Unit> NeutralUnits = source.NeutralUnits();
+	writeU32(out, uint32_t(NeutralUnits.size()));
+	for (const sc2::Unit & u : NeutralUnits)
+	{
+		writeU64(out, u.tag);
+		writeU32(out, static_cast<uint32_t>(u.unit_type.ToType()));
+		writeFloat(out, u.pos.x);
+		writeFloat(out, u.pos.y);
+		writeFloat(out, u.pos.z);
+		writeFloat(out, u.radius);
+		writeI32(out, u.mineral_contents);
+		writeI32(out, u.vespene_contents);
+	}
+
+	if (!out) throw Exception("SnapshotMapSource: could not write " + fileName);
+}
+
+
+void SnapshotMapSource::ReadGrids(utils::BitGrid & Pathable, utils::BitGrid & Placable) const
+{
+	if ((Pathable.Width() == m_Pathable.Width()) && (Pathable.Height() == m_Pathable.Height()) &&
+		(Placable.Width() == m_Placable.Width()) && (Placable.Height() == m_Placable.Height()))
+	{
+		Pathable = m_Pathable;
+		Placable = m_Placable;
+	}
+	else MapSource::ReadGrids(Pathable, Placable);
+}
+
+
+bool SnapshotMapSource::WalkBit(const utils::BitGrid & Plane, const sc2::Point2D & p) const
+{
+	const int i = gridIndex(p, 4*m_width, 4*m_height);
+	return (i >= 0) && Plane.Get(i % (4*m_width), i / (4*m_width));
+}
+
+
+bool SnapshotMapSource::IsPathable(const sc2::Point2D & p) const
+{
+	return WalkBit(m_Pathable, p);
+}
+
+
+bool SnapshotMapSource::IsPlacable(const sc2::Point2D & p) const
+{
+	return WalkBit(m_Placable, p);
+}
+
+
+float SnapshotMapSource::TerrainHeight(const sc2::Point2D & p) const
+{
+	const int i = gridIndex(p, m_width, m_height);
+	return (i >= 0) ? m_Heights[i] : 0.0f;
+}
+
+
+} // namespace SC2EM
@@ -0,0 +1,150 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is part of the BWEM Library.
+// BWEM is free software, licensed under the MIT/X11 License.
+// A copy of the license is provided with the library in the LICENSE file.
+// Copyright (c) 2015, 2017, Igor Dimitrijevic
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef BWEM_MAP_SOURCE_H
+#define BWEM_MAP_SOURCE_H
+
+#include "Sc2Bindings.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "bitGrid.h"
+#include "defs.h"
+
+
+namespace SC2EM
+{
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class MapSource
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+//
+// MapSource provides the raw terrain information Map::Initialize() needs:
+//	- the size of the map and the starting locations
+//	- the pathing grid, the placement grid and the height map
+//	- the neutral units (Minerals, Geysers and StaticBuildings)
+//
+// The queries are the ones of sc2::ObservationInterface, so that a live game (ObservationMapSource)
+// and a recorded terrain snapshot (SnapshotMapSource) can be used interchangeably.
+
+class MapSource
+{
+public:
+	virtual									~MapSource() = default;
+
+	// Returns the size of the Map in Tiles.
+	virtual Sc2Bindings::TilePosition		Size() const = 0;
+
+	virtual std::vector<sc2::Point2D>		StartLocations() const = 0;
+
+	virtual bool							IsPathable(const sc2::Point2D & p) const = 0;
+	virtual bool							IsPlacable(const sc2::Point2D & p) const = 0;
+	virtual float							TerrainHeight(const sc2::Point2D & p) const = 0;
+
+	// Returns a copy of each neutral unit (not only the Minerals, Geysers and StaticBuildings).
+	virtual std::vector<sc2::Unit>			NeutralUnits() const = 0;
+
+	// Fills Pathable and Placable with IsPathable and IsPlacable at each integer point (x, y) of the grids.
+	// Map::Initialize calls it once, with 4*Size().x x 4*Size().y grids.
+	// The default implementation just performs the queries. Sources that hold packed grids should override it.
+	virtual void							ReadGrids(utils::BitGrid & Pathable, utils::BitGrid & Placable) const;
+};
+
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class ObservationMapSource
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Forwards each query to a live sc2::ObservationInterface.
+//
+
+class ObservationMapSource : public MapSource
+{
+public:
+	explicit								ObservationMapSource(const sc2::ObservationInterface * obs) : m_obs(obs) {}
+
+	Sc2Bindings::TilePosition				Size() const override;
+	std::vector<sc2::Point2D>				StartLocations() const override;
+	bool									IsPathable(const sc2::Point2D & p) const override		{ return m_obs->IsPathable(p); }
+	bool									IsPlacable(const sc2::Point2D & p) const override		{ return m_obs->IsPlacable(p); }
+	float									TerrainHeight(const sc2::Point2D & p) const override	{ return m_obs->TerrainHeight(p); }
+	std::vector<sc2::Unit>					NeutralUnits() const override;
+
+private:
+	const sc2::ObservationInterface *		m_obs;
+};
+
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class SnapshotMapSource
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+//
+// A MapSource read from a terrain snapshot file, which makes it possible to run the whole analysis without any game client.
+// A snapshot file is made by calling SnapshotMapSource::Save (usually with an ObservationMapSource, in onStart()).
+//
+// The snapshot records exactly the queries performed by Map::Initialize():
+//	- IsPathable and IsPlacable for each integer point inside the WalkSize() rectangle (packed as 2 bit planes)
+//	- TerrainHeight for each integer point inside the Size() rectangle
+// Any other query returns false (resp. 0).
+//
+// The file format is little-endian binary:
+//	"SC2EMMAP"  uint32 version  int32 width  int32 height  (in Tiles)
+//	uint32 count  { float x  float y }*count												(start locations)
+//	uint8 pathable[(4*width * 4*height + 7) / 8]  uint8 placable[(4*width * 4*height + 7) / 8]
+//	float height[width * height]
+//	uint32 count  { uint64 tag  uint32 unit_type  float x y z  float radius  int32 minerals  int32 vespene }*count
+//
+// Errors (missing file, bad header, truncated file) are reported by throwing an Exception.
+
+class SnapshotMapSource : public MapSource
+{
+public:
+	static const uint32_t					version = 1;
+
+	explicit								SnapshotMapSource(const std::string & fileName);
+
+	// Records source into the file fileName.
+	static void								Save(const MapSource & source, const std::string & fileName);
+
+	Sc2Bindings::TilePosition				Size() const override						{ return Sc2Bindings::TilePosition(static_cast<float>(m_width), static_cast<float>(m_height)); }
+	std::vector<sc2::Point2D>				StartLocations() const override				{ return m_StartLocations; }
+	bool									IsPathable(const sc2::Point2D & p) const override;
+	bool									IsPlacable(const sc2::Point2D & p) const override;
+	float									TerrainHeight(const sc2::Point2D & p) const override;
+	std::vector<sc2::Unit>					NeutralUnits() const override				{ return m_NeutralUnits; }
+	void									ReadGrids(utils::BitGrid & Pathable, utils::BitGrid & Placable) const override;
+
+private:
+	bool									WalkBit(const utils::BitGrid & Plane, const sc2::Point2D & p) const;
+
+	int										m_width;
+	int										m_height;
+	std::vector<sc2::Point2D>				m_StartLocations;
+	utils::BitGrid							m_Pathable;
+	utils::BitGrid							m_Placable;
+	std::vector<float>						m_Heights;
+	std::vector<sc2::Unit>					m_NeutralUnits;
+};
+
+
+} // namespace SC2EM
+
+
+#endif
+
@@ -0,0 +1,165 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is part of the BWEM Library.
+// BWEM is free software, licensed under the MIT/X11 License.
+// A copy of the license is provided with the library in the LICENSE file.
+// Copyright (c) 2015, 2017, Igor Dimitrijevic
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#include "mapStats.h"
+#include <sstream>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+using namespace std;
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  Allocation counters
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Replaces the global operator new / operator delete, so that the allocations made by the whole
+// program are counted. Each block is prefixed with its size, so that the size of the heap can be tracked.
+// The array and sized forms of the standard library forward to these ones.
+//
+
+#if BWEM_COUNT_ALLOCATIONS
+
+namespace
+{
+	atomic<int64_t>		allocations(0);
+	atomic<int64_t>		heapBytes(0);
+	atomic<int64_t>		heapPeak(0);
+
+	const size_t		headerSize = alignof(max_align_t) > sizeof(size_t) ? alignof(max_align_t) : sizeof(size_t);
+}
+
+
+void * operator new(size_t size)
+{
+	void * p = malloc(headerSize + size);
+	if (!p) throw bad_alloc();
+
+	*static_cast<size_t *>(p) = size;
+
+	++allocations;
+	const int64_t bytes = heapBytes += size;
+	int64_t peak = heapPeak;
+	while ((bytes > peak) && !heapPeak.compare_exchange_weak(peak, bytes)) {}
+
+	return static_cast<char *>(p) + headerSize;
+}
+
+
+void operator delete(void * p) noexcept
+{
+	if (!p) return;
+
+	void * block = static_cast<char *>(p) - headerSize;
+	heapBytes -= *static_cast<size_t *>(block);
+	free(block);
+}
+
+
+namespace SC2EM {
+namespace detail {
+
+int64_t allocationCount()	{ return allocations; }
+int64_t heapSizeBytes()		{ return heapBytes; }
+int64_t heapPeakBytes()		{ return heapPeak; }
+void resetHeapPeak()		{ heapPeak = heapBytes.load(); }
+
+}} // namespace SC2EM::detail
+
+#else
+
+namespace SC2EM {
+namespace detail {
+
+int64_t allocationCount()	{ return -1; }
+int64_t heapSizeBytes()		{ return -1; }
+int64_t heapPeakBytes()		{ return -1; }
+void resetHeapPeak()		{}
+
+}} // namespace SC2EM::detail
+
+#endif // BWEM_COUNT_ALLOCATIONS
+
+
+
+namespace SC2EM {
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class InitializationStats
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+
+const InitializationStats::Stage * InitializationStats::GetStage(const string & name) const
+{
+	for (const Stage & stage : m_Stages)
+		if (stage.name == name) return &stage;
+
+	return nullptr;
+}
+
+
+double InitializationStats::TotalMilliseconds() const
+{
+	double total = 0;
+	for (const Stage & stage : m_Stages)
+		total += stage.milliseconds;
+
+	return total;
+}
+
+
+string InitializationStats::ToJson() const
+{
+	ostringstream out;
+	out << "{\"fromCache\":" << (FromCache() ? "true" : "false") << ",\"totalMs\":" << TotalMilliseconds() << ",\"stages\":[";
+
+	for (const Stage & stage : m_Stages)
+	{
+		if (&stage != &m_Stages.front()) out << ",";
+		out << "{\"name\":\"" << stage.name << "\",\"ms\":" << stage.milliseconds
+			<< ",\"allocations\":" << stage.allocations << ",\"peakBytes\":" << stage.peakBytes << "}";
+	}
+
+	out << "]}";
+	return out.str();
+}
+
+
+void InitializationStats::BeginStage()
+{
+	detail::resetHeapPeak();
+	m_startHeapBytes = detail::heapSizeBytes();
+	m_startAllocations = detail::allocationCount();
+	m_start = chrono::steady_clock::now();
+}
+
+
+void InitializationStats::EndStage(const char * name)
+{
+	const double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - m_start).count();
+	const int64_t allocations = detail::allocationCount();
+	const int64_t peakBytes = detail::heapPeakBytes();
+
+	m_Stages.push_back(Stage{name, milliseconds,
+							(allocations < 0) ? -1 : allocations - m_startAllocations,
+							(peakBytes < 0) ? -1 : peakBytes - m_startHeapBytes});
+
+	BeginStage();
+}
+
+
+} // namespace SC2EM
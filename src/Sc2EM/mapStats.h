@@ -0,0 +1,99 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is part of the BWEM Library.
+// BWEM is free software, licensed under the MIT/X11 License.
+// A copy of the license is provided with the library in the LICENSE file.
+// Copyright (c) 2015, 2017, Igor Dimitrijevic
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef BWEM_MAP_STATS_H
+#define BWEM_MAP_STATS_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include "defs.h"
+
+
+namespace SC2EM
+{
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class InitializationStats
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Measures the cost of each stage of Map::Initialize (LoadData, DecideSeasOrLakes, ... , Graph::CreateBases).
+// Cf. Map::GetInitializationStats.
+//
+// The wall time is always measured.
+// The allocation count and the heap peak are only measured if BWEM_COUNT_ALLOCATIONS is enabled (Cf. defs.h),
+// otherwise they are set to -1.
+//
+
+class InitializationStats
+{
+public:
+	struct Stage
+	{
+		std::string						name;
+		double							milliseconds;
+		int64_t							allocations;	// number of calls to operator new during this stage
+		int64_t							peakBytes;		// maximal growth of the heap (operator new, whole process) during this stage, over its size when the stage began
+	};
+
+	// Returns the stages of the last call to Map::Initialize, in the order they were run.
+	const std::vector<Stage> &			Stages() const					{ return m_Stages; }
+
+	// Returns the Stage named name, if any.
+	const Stage *						GetStage(const std::string & name) const;
+
+	double								TotalMilliseconds() const;
+
+	// Tells whether the last call to Map::Initialize read the analysis from a cache file (Cf. Map::InitializedFromCache).
+	bool								FromCache() const				{ return m_fromCache; }
+
+	// Returns the stats in JSON format, on one line:
+	// {"fromCache":false,"totalMs":12.3,"stages":[{"name":"LoadData","ms":1.2,"allocations":34,"peakBytes":5678}, ...]}
+	std::string							ToJson() const;
+
+	////////////////////////////////////////////////////////////////////////////
+//	Details: The functions below are used by the BWEM's internals
+
+	// Starts the measure of the next stage.
+	void								BeginStage();
+
+	// Ends the measure of the current stage, and records it under the name name.
+	// Also starts the measure of the next stage.
+	void								EndStage(const char * name);
+
+	void								SetFromCache(bool fromCache)	{ m_fromCache = fromCache; }
+
+private:
+	std::vector<Stage>					m_Stages;
+	std::chrono::steady_clock::time_point m_start;
+	int64_t								m_startAllocations = 0;
+	int64_t								m_startHeapBytes = 0;
+	bool								m_fromCache = false;
+};
+
+
+namespace detail
+{
+	// Counters maintained by the replacement of the global operator new (only if BWEM_COUNT_ALLOCATIONS is enabled).
+	int64_t								allocationCount();
+	int64_t								heapSizeBytes();
+	int64_t								heapPeakBytes();
+	void								resetHeapPeak();
+}
+
+
+} // namespace SC2EM
+
+
+#endif
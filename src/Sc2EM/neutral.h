@@ -106,6 +106,7 @@ namespace SC2EM {
 	//	Details: The functions below are used by the BWEM's internals
 
 		void							SetBlocking(const std::vector<Sc2Bindings::WalkPosition> & blockedAreas);
+		const std::vector<Sc2Bindings::WalkPosition> &	BlockingDoors() const { return m_blockedAreas; }
 
 	protected:
 		Neutral(sc2::Unit u, Map * pMap);
@@ -0,0 +1,204 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is part of the BWEM Library.
+// BWEM is free software, licensed under the MIT/X11 License.
+// A copy of the license is provided with the library in the LICENSE file.
+// Copyright (c) 2015, 2017, Igor Dimitrijevic
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef BWEM_SHORTEST_PATHS_H
+#define BWEM_SHORTEST_PATHS_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "defs.h"
+
+
+namespace SC2EM {
+namespace utils {
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class ShortestPathSearch
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Dijkstra's algorithm over any graph whose nodes are numbered from 0 to nodeCount-1.
+// The caller drives the search and provides the edges:
+//
+//	ShortestPathSearch<TilePosition> Search;
+//	Search.Begin(nodeCount);
+//	Search.Relax(indexOf(start), start, 0);
+//	while (!Search.Empty())
+//	{
+//		const int current = Search.Pop();					// the open node with the smallest distance, now closed
+//		for (each neighbour next of Search.Node(current))
+//			Search.Relax(indexOf(next), next, Search.Distance(current) + weight, current);
+//	}
+//
+// Each node reached stores a TNode (typically its position), its distance and its parent (the node it was reached from),
+// so that the shortest paths can be retrieved backwards using Parent().
+//
+// The open nodes are kept in an indexed d-ary heap (Arity children per node), so that decreasing a distance is O(log n).
+// Among nodes with the same distance, the one whose distance was set first is popped first.
+//
+// The per node arrays are allocated once and reused from one search to the other:
+// Begin() only increments a generation stamp, so that every node becomes unreached in O(1).
+// Therefore a ShortestPathSearch can be kept and reused for many searches over the same graph, without any allocation.
+//
+
+template<class TNode, int Arity = 4>
+class ShortestPathSearch
+{
+	static_assert(Arity >= 2, "the heap needs at least 2 children per node");
+
+public:
+	// Starts a new search over nodeCount nodes: every node becomes unreached.
+	void						Begin(int nodeCount)
+	{
+		bwem_assert(nodeCount >= 0);
+		if (int(m_Stamps.size()) != nodeCount)
+		{
+			m_Stamps.assign(nodeCount, 0);
+			m_Distances.resize(nodeCount);
+			m_Parents.resize(nodeCount);
+			m_Orders.resize(nodeCount);
+			m_HeapIndexes.resize(nodeCount);
+			m_Nodes.resize(nodeCount);
+			m_stamp = 0;
+		}
+
+		if (++m_stamp == 0)		// the stamps wrapped around
+		{
+			std::fill(m_Stamps.begin(), m_Stamps.end(), 0);
+			m_stamp = 1;
+		}
+
+		m_Heap.clear();
+		m_order = 0;
+	}
+
+	int							NodeCount() const				{ return int(m_Stamps.size()); }
+
+	// Offers the distance dist to the node n (reached from the node parent, or from nowhere if parent == -1).
+	// Returns true if n was not reached yet or if dist is smaller than its current distance (then node replaces Node(n)).
+	// Closed nodes (already popped) are never updated.
+	bool						Relax(int n, const TNode & node, int dist, int parent = -1)
+	{
+		if (!Reached(n))
+		{
+			m_Stamps[n] = m_stamp;
+			m_Nodes[n] = node;
+			m_Distances[n] = dist;
+			m_Parents[n] = parent;
+			m_Orders[n] = m_order++;
+			m_HeapIndexes[n] = int(m_Heap.size());
+			m_Heap.push_back(n);
+			SiftUp(m_HeapIndexes[n]);
+			return true;
+		}
+
+		if (Closed(n) || (dist >= m_Distances[n])) return false;
+
+		m_Nodes[n] = node;
+		m_Distances[n] = dist;
+		m_Parents[n] = parent;
+		m_Orders[n] = m_order++;
+		SiftUp(m_HeapIndexes[n]);
+		return true;
+	}
+
+	bool						Empty() const					{ return m_Heap.empty(); }
+
+	// Removes the open node with the smallest distance, closes it and returns it.
+	int							Pop()
+	{
+		bwem_assert(!Empty());
+		const int top = m_Heap.front();
+		m_HeapIndexes[top] = closed;
+
+		const int last = m_Heap.back();
+		m_Heap.pop_back();
+		if (!m_Heap.empty())
+		{
+			m_Heap.front() = last;
+			m_HeapIndexes[last] = 0;
+			SiftDown(0);
+		}
+
+		return top;
+	}
+
+	// Returns true if n has been reached during the current search (i.e. has a distance, either final or tentative).
+	bool						Reached(int n) const			{ bwem_assert((0 <= n) && (n < NodeCount())); return m_Stamps[n] == m_stamp; }
+
+	// Returns true if the distance of n is final.
+	bool						Closed(int n) const				{ return Reached(n) && (m_HeapIndexes[n] == closed); }
+
+	const TNode &				Node(int n) const				{ bwem_assert(Reached(n)); return m_Nodes[n]; }
+	int							Distance(int n) const			{ bwem_assert(Reached(n)); return m_Distances[n]; }
+	int							Parent(int n) const				{ bwem_assert(Reached(n)); return m_Parents[n]; }
+
+private:
+	enum { closed = -1 };
+
+	bool						Before(int a, int b) const
+	{
+		return (m_Distances[a] < m_Distances[b]) || ((m_Distances[a] == m_Distances[b]) && (m_Orders[a] < m_Orders[b]));
+	}
+
+	void						Place(int i, int n)				{ m_Heap[i] = n; m_HeapIndexes[n] = i; }
+
+	void						SiftUp(int i)
+	{
+		const int n = m_Heap[i];
+		while (i > 0)
+		{
+			const int parent = (i - 1) / Arity;
+			if (!Before(n, m_Heap[parent])) break;
+			Place(i, m_Heap[parent]);
+			i = parent;
+		}
+		Place(i, n);
+	}
+
+	void						SiftDown(int i)
+	{
+		const int n = m_Heap[i];
+		const int size = int(m_Heap.size());
+		for (;;)
+		{
+			const int firstChild = i * Arity + 1;
+			if (firstChild >= size) break;
+
+			int best = firstChild;
+			for (int c = firstChild + 1 ; c < std::min(firstChild + Arity, size) ; ++c)
+				if (Before(m_Heap[c], m_Heap[best])) best = c;
+
+			if (!Before(m_Heap[best], n)) break;
+			Place(i, m_Heap[best]);
+			i = best;
+		}
+		Place(i, n);
+	}
+
+	std::vector<uint32_t>		m_Stamps;
+	std::vector<int>			m_Distances;
+	std::vector<int>			m_Parents;
+	std::vector<uint32_t>		m_Orders;
+	std::vector<int>			m_HeapIndexes;		// index in m_Heap, or closed
+	std::vector<TNode>			m_Nodes;
+	std::vector<int>			m_Heap;
+	uint32_t					m_stamp = 0;
+	uint32_t					m_order = 0;
+};
+
+
+}} // namespace SC2EM::utils
+
+
+#endif
@@ -0,0 +1,70 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is part of the BWEM Library.
+// BWEM is free software, licensed under the MIT/X11 License.
+// A copy of the license is provided with the library in the LICENSE file.
+// Copyright (c) 2015, 2017, Igor Dimitrijevic
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef BWEM_TILE_PATH_H
+#define BWEM_TILE_PATH_H
+
+#include "Position.h"
+#include <vector>
+#include "defs.h"
+
+
+namespace SC2EM {
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class TilePath
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+//
+// A path made of 8-connected walkable Tiles, as computed by Map::GetTilePath.
+// A TilePath owns the memory of its Tiles and Map::GetTilePath only clears it before filling it again,
+// so the memory is kept from one call to the other: a TilePath reused for many paths (typically, one per unit or per thread)
+// stops allocating as soon as it has grown to the size of the longest path.
+//
+
+class TilePath
+{
+public:
+	// Removes all the Tiles, but keeps the memory.
+	void							Clear()						{ m_Tiles.clear(); m_length = -1; }
+
+	bool							empty() const				{ return m_Tiles.empty(); }
+	int								size() const				{ return int(m_Tiles.size()); }
+
+	// The i-th Tile of the path. The first one is the Tile of the start, the last one is the Tile of the target.
+	Sc2Bindings::TilePosition		operator[](int i) const		{ return Sc2Bindings::TilePosition(m_Tiles[i]); }
+
+	// The center MiniTile of the i-th Tile of the path.
+	Sc2Bindings::WalkPosition		WalkPositionAt(int i) const	{ return Sc2Bindings::WalkPosition(Sc2Bindings::TilePosition(m_Tiles[i])) + Sc2Bindings::WalkPosition(2, 2); }
+
+	const std::vector<Sc2Bindings::TileCoord> &	Tiles() const	{ return m_Tiles; }
+
+	// The length of the path in pixels (Cf. Map::GetTilePath), or -1 if there is no path.
+	int								Length() const				{ return m_length; }
+
+	////////////////////////////////////////////////////////////////////////////
+	//	Details: The functions below are used by the BWEM's internals
+
+	std::vector<Sc2Bindings::TileCoord> &	Tiles()				{ return m_Tiles; }
+	void							Add(Sc2Bindings::TileCoord t)	{ if (m_Tiles.empty() || (m_Tiles.back() != t)) m_Tiles.push_back(t); }
+	void							SetLength(int length)		{ m_length = length; }
+
+private:
+	std::vector<Sc2Bindings::TileCoord>	m_Tiles;
+	int								m_length = -1;
+};
+
+
+} // namespace SC2EM
+
+
+#endif
@@ -116,10 +116,9 @@ namespace SC2EM {
 	// The use of Tiles is further facilitated by some functions like Tile::AreaId or Tile::MinAltitude
 	// which somewhat aggregate the MiniTile's corresponding information
 	//
-	// Tiles inherit utils::Markable, which provides marking ability
 	// Tiles inherit utils::UserData, which provides free-to-use data.
 
-	class Tile : public utils::Markable<Tile, int>, public utils::UserData
+	class Tile : public utils::UserData
 	{
 	public:
 		// Corresponds to BWAPI::isBuildable
@@ -176,8 +175,6 @@ namespace SC2EM {
 		void				ResetAreaId() { m_areaId = 0; }
 		void				SetMinAltitude(altitude_t a) { bwem_assert(a >= 0); m_minAltitude = a; }
 		void				RemoveNeutral(Neutral * pNeutral) { bwem_assert(pNeutral && (m_pNeutral == pNeutral)); utils::unused(pNeutral); m_pNeutral = nullptr; }
-		int					InternalData() const { return m_internalData; }
-		void				SetInternalData(int data) const { m_internalData = data; }
 
 
 	private:
@@ -192,7 +189,6 @@ namespace SC2EM {
 		Neutral *			m_pNeutral = nullptr;
 		altitude_t			m_minAltitude;
 		Area::id			m_areaId = 0;
-		mutable int			m_internalData = 0;
 		Bits				m_bits;
 	};
 
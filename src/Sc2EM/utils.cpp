@@ -22,6 +22,22 @@ namespace utils {
 //ofstream Log("bwapi-data/write/log.txt");
 
 
+static atomic<int> maxThreads(0);
+
+void SetMaxThreads(int n)
+{
+	bwem_assert(n >= 0);
+	maxThreads = n;
+}
+
+
+int MaxThreads()
+{
+	const int n = maxThreads;
+	return max(1, n ? n : static_cast<int>(thread::hardware_concurrency()));
+}
+
+
 bool canWrite(const string & fileName)
 {
 	ofstream out(fileName);
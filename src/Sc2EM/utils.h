@@ -20,6 +20,8 @@
 #include <cstdint>
 #include <limits>
 #include <fstream>
+#include <thread>
+#include <atomic>
 #include "defs.h"
 
 
@@ -193,52 +195,81 @@ inline void fast_erase(std::vector<T> & Vector, int i)
 }
 
 
-struct compare2nd
-{
-    template <typename T>
-    bool operator()(const T & a, const T & b)
-    {
-        return a.second < b.second;
-    }
-};
+// Caps the number of threads used by parallel_for (and therefore by Map::Initialize).
+// 0, the default, means std::thread::hardware_concurrency(). 1 disables the multithreading.
+void SetMaxThreads(int n);
 
+// Returns the number of threads parallel_for may use (>= 1).
+int MaxThreads();
 
-//////////////////////////////////////////////////////////////////////////////////////////////
-//                                                                                          //
-//                                  class Markable
-//                                                                                          //
-//////////////////////////////////////////////////////////////////////////////////////////////
-//
-//  Provides efficient marking ability.
-//
-//  Usage: class MyNode : (public) Markable<MyNode, unsigned> {...};
-//
-//  Note: This implementation uses a static member.
-//
 
-template<class Derived, class Mark>
-class Markable
+// Calls f(i) for each i in [begin, end), using at most MaxThreads() threads.
+// Each thread repeatedly takes the next index not processed yet, so that the threads stay busy
+// even when the calls have very different costs.
+// f must be safe to call concurrently for different values of i.
+template<class F>
+void parallel_for(int begin, int end, const F & f)
+{
+	const int n = end - begin;
+	if (n <= 0) return;
+
+	const int threads = std::min(n, MaxThreads());
+	if (threads == 1)
+	{
+		for (int i = begin ; i < end ; ++i) f(i);
+		return;
+	}
+
+	std::atomic<int> next(begin);
+	auto work = [&]()
+	{
+		for (int i = next++ ; i < end ; i = next++) f(i);
+	};
+
+	std::vector<std::thread> Workers;
+	Workers.reserve(threads - 1);
+	for (int t = 1 ; t < threads ; ++t) Workers.emplace_back(work);
+	work();
+	for (std::thread & worker : Workers) worker.join();
+}
+
+
+// A view of a contiguous array of T, in the spirit of std::span.
+// Lets the Map expose its internal arrays without committing to a container.
+template<class T>
+class Span
 {
 public:
-    typedef Mark mark_t;
+	typedef T				value_type;
+	typedef T *				iterator;
+
+							Span() : m_data(nullptr), m_size(0) {}
+							Span(T * data, size_t size) : m_data(data), m_size(size) {}
 
-                            Markable() : m_lastMark(0) {}
+	T *						data() const					{ return m_data; }
+	size_t					size() const					{ return m_size; }
+	bool					empty() const					{ return m_size == 0; }
+	T *						begin() const					{ return m_data; }
+	T *						end() const						{ return m_data + m_size; }
+	T &						operator[](size_t i) const		{ bwem_assert_debug_only(i < m_size); return m_data[i]; }
 
-    bool                    Marked() const      { return m_lastMark == m_currentMark; }
-    void                    SetMarked() const   { m_lastMark = m_currentMark; }
-    void                    SetUnmarked() const { m_lastMark = m_currentMark-1; }
-    static void             UnmarkAll()         { ++m_currentMark; }
+	// Returns the view of the count elements starting at offset (e.g. one row of a grid).
+	Span					subspan(size_t offset, size_t count) const	{ bwem_assert(offset + count <= m_size); return Span(m_data + offset, count); }
 
 private:
-    mutable mark_t          m_lastMark;
-    static mark_t           m_currentMark;
+	T *						m_data;
+	size_t					m_size;
 };
 
 
-template<class Derived, class Mark>
-Mark Markable<Derived, Mark>::m_currentMark = 0;
-
-
+struct compare2nd
+{
+    template <typename T>
+    bool operator()(const T & a, const T & b)
+    {
+        return a.second < b.second;
+    }
+};
 
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,103 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is part of the BWEM Library.
+// BWEM is free software, licensed under the MIT/X11 License.
+// A copy of the license is provided with the library in the LICENSE file.
+// Copyright (c) 2015, 2017, Igor Dimitrijevic
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef BWEM_VISITED_GRID_H
+#define BWEM_VISITED_GRID_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "defs.h"
+
+
+namespace SC2EM {
+namespace utils {
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class VisitedGrid
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Scratch memory for the searches over a width x height grid (Cf. Map::BreadthFirstSearch):
+//	- a visited mark per cell, stored as a generation stamp: starting a new search just increments the stamp,
+//	  so that every cell becomes unvisited in O(1).
+//	- a FIFO of positions. Each cell is pushed at most once per search, so a buffer of width x height (+ 1 for the start)
+//	  positions never overflows and the FIFO never has to wrap around.
+// Both are allocated once (at the first search, or when the grid size changes) and then reused.
+//
+// A VisitedGrid can only serve one search at a time: use a Session to acquire it.
+//
+
+template<class TPosition>
+class VisitedGrid
+{
+public:
+	// Acquires the VisitedGrid for a new search, for the lifetime of the Session.
+	class Session
+	{
+	public:
+								Session(VisitedGrid & grid, int width, int height) : m_grid(grid) { m_grid.Begin(width, height); }
+								~Session()					{ m_grid.m_busy = false; }
+
+								Session(const Session &) = delete;
+		Session &				operator=(const Session &) = delete;
+
+	private:
+		VisitedGrid &			m_grid;
+	};
+
+	// Returns true if a Session is currently using this VisitedGrid (nested searches must use another one).
+	bool						Busy() const				{ return m_busy; }
+
+	bool						Visited(int i) const		{ bwem_assert((0 <= i) && (i < int(m_Stamps.size()))); return m_Stamps[i] == m_stamp; }
+	void						SetVisited(int i)			{ bwem_assert((0 <= i) && (i < int(m_Stamps.size()))); m_Stamps[i] = m_stamp; }
+
+	bool						Empty() const				{ return m_head == m_tail; }
+	void						Push(const TPosition & p)	{ bwem_assert(m_tail < m_Queue.size()); m_Queue[m_tail++] = p; }
+	TPosition					Pop()						{ bwem_assert(!Empty()); return m_Queue[m_head++]; }
+
+private:
+	void						Begin(int width, int height)
+	{
+		bwem_assert(!m_busy);
+		m_busy = true;
+
+		const size_t size = size_t(width) * height;
+		if (m_Stamps.size() != size)
+		{
+			m_Stamps.assign(size, 0);
+			m_Queue.resize(size + 1);
+			m_stamp = 0;
+		}
+
+		if (++m_stamp == 0)		// the stamps wrapped around: cells stamped 2^32 searches ago would look visited
+		{
+			std::fill(m_Stamps.begin(), m_Stamps.end(), 0);
+			m_stamp = 1;
+		}
+
+		m_head = m_tail = 0;
+	}
+
+	std::vector<uint32_t>		m_Stamps;
+	std::vector<TPosition>		m_Queue;
+	uint32_t					m_stamp = 0;
+	size_t						m_head = 0;
+	size_t						m_tail = 0;
+	bool						m_busy = false;
+};
+
+
+}} // namespace SC2EM::utils
+
+
+#endif
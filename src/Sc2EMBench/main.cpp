@@ -0,0 +1,380 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is part of the BWEM Library.
+// BWEM is free software, licensed under the MIT/X11 License.
+// A copy of the license is provided with the library in the LICENSE file.
+// Copyright (c) 2015, 2017, Igor Dimitrijevic
+//
+//////////////////////////////////////////////////////////////////////////
+//
+// Sc2EMBench: measures Map::Initialize and the main queries, without any game client.
+//
+// Usage: Sc2EMBench [--sizes 128,176,256] [--seed n] [--reps n] [--queries n] [--threads n] [--max-threads n] [--snapshot file]...
+//
+// Each synthetic map (one per size) and each terrain snapshot (Cf. SnapshotMapSource) is initialized --reps times,
+// then the queries are timed on it.
+// Each result is printed on its own line, as a JSON object with a fixed set of keys:
+//	{"bench":"Initialize","map":"synthetic-128","reps":3,"minMs":..,"medianMs":..,"stats":{...}}
+//	{"bench":"GetPath","map":"synthetic-128","ops":10000,"totalMs":..,"nsPerOp":..,"checksum":..}
+// The checksum of a query bench only depends on the results of the queries, so it also detects behaviour changes.
+// GetPaths answers the queries of GetPath with a single batch call, so both must have the same checksum.
+// Each result of GetPaths is also compared with the one of GetPath:
+//	{"bench":"BatchPaths","map":"synthetic-128","queries":..,"mismatches":0}
+// The path between each pair of ChokePoints must be the same in both directions:
+//	{"bench":"ReversePaths","map":"synthetic-128","pairs":..,"mismatches":0}
+//
+// With --threads n (n > 1), GetPath, GetNearestArea and GetGroundDistance are also run by n threads at the same time,
+// and their results are compared with the results of a single thread:
+//	{"bench":"Concurrency","map":"synthetic-128","threads":4,"ops":..,"totalMs":..,"mismatches":0}
+// Sc2EMBench exits with 2 if any result differs, or if any BatchPaths or ReversePaths mismatch was found.
+// --max-threads n caps the number of threads used by Map::Initialize (Cf. Map::SetMaxThreads).
+//
+
+
+#include "bwem.h"
+#include "syntheticMapSource.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace SC2EM;
+using namespace SC2EM::bench;
+using namespace SC2EM::utils;
+using namespace Sc2Bindings;
+
+using namespace std;
+
+
+namespace
+{
+
+struct Options
+{
+	vector<int>						Sizes = {128, 176, 256};
+	vector<string>					Snapshots;
+	uint64_t						seed = 1;
+	int								reps = 3;
+	int								queries = 10000;
+	int								threads = 1;
+};
+
+
+Options parseOptions(int argc, char * argv[])
+{
+	Options options;
+	for (int i = 1 ; i < argc ; i += 2)
+	{
+		const string option = argv[i];
+		if (i + 1 == argc)
+		{
+			fprintf(stderr, "Sc2EMBench: missing value for option %s\n", option.c_str());
+			exit(1);
+		}
+
+		const string value = argv[i+1];
+		if (option == "--sizes")
+		{
+			options.Sizes.clear();
+			istringstream in(value);
+			for (string size ; getline(in, size, ',') ; )
+				options.Sizes.push_back(atoi(size.c_str()));
+		}
+		else if (option == "--seed")		options.seed = strtoull(value.c_str(), nullptr, 10);
+		else if (option == "--reps")		options.reps = max(1, atoi(value.c_str()));
+		else if (option == "--queries")		options.queries = max(1, atoi(value.c_str()));
+		else if (option == "--threads")		options.threads = max(1, atoi(value.c_str()));
+		else if (option == "--max-threads")	Map::SetMaxThreads(max(0, atoi(value.c_str())));
+		else if (option == "--snapshot")	options.Snapshots.push_back(value);
+		else
+		{
+			fprintf(stderr, "Sc2EMBench: unknown option %s\n", option.c_str());
+			exit(1);
+		}
+	}
+
+	return options;
+}
+
+
+double elapsedMilliseconds(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+
+void benchInitialize(Map & theMap, const MapSource & source, const string & mapName, int reps)
+{
+	vector<double> Times;
+	for (int r = 0 ; r < reps ; ++r)
+	{
+		const auto start = chrono::steady_clock::now();
+		theMap.Initialize(source);
+		Times.push_back(elapsedMilliseconds(start));
+	}
+	theMap.EnableAutomaticPathAnalysis();
+	theMap.FindBasesForStartingLocations();
+
+	sort(Times.begin(), Times.end());
+	printf("{\"bench\":\"Initialize\",\"map\":\"%s\",\"reps\":%d,\"minMs\":%.3f,\"medianMs\":%.3f,\"areas\":%d,\"chokePoints\":%d,\"bases\":%d,\"stats\":%s}\n",
+		mapName.c_str(), reps, Times.front(), Times[Times.size() / 2],
+		(int)theMap.Areas().size(), theMap.ChokePointCount(), theMap.BaseCount(), theMap.GetInitializationStats().ToJson().c_str());
+	fflush(stdout);
+}
+
+
+// Runs op(i) for i in [0, ops), and prints the time per call.
+// op returns a value that is folded into the checksum.
+void benchQuery(const string & name, const string & mapName, int ops, const function<uint64_t(int)> & op)
+{
+	uint64_t checksum = 14695981039346656037ull;
+	const auto start = chrono::steady_clock::now();
+	for (int i = 0 ; i < ops ; ++i)
+		checksum = (checksum ^ op(i)) * 1099511628211ull;
+	const double totalMs = elapsedMilliseconds(start);
+
+	printf("{\"bench\":\"%s\",\"map\":\"%s\",\"ops\":%d,\"totalMs\":%.3f,\"nsPerOp\":%.1f,\"checksum\":\"%016llx\"}\n",
+		name.c_str(), mapName.c_str(), ops, totalMs, totalMs * 1e6 / ops, (unsigned long long)checksum);
+	fflush(stdout);
+}
+
+
+// The query points are drawn once, so that the benchmarks do not measure the random generator.
+struct QueryPoints
+{
+	QueryPoints(const Map & theMap, uint64_t seed, int queries)
+		: Positions(2 * queries), WalkPositions(queries), TilePositions(queries)
+	{
+		Random rng(seed + 99);
+		const int width = static_cast<int>(theMap.Size().x);
+		const int height = static_cast<int>(theMap.Size().y);
+		for (Position & p : Positions)			p = Position(static_cast<float>(rng.Next() % (32*width)), static_cast<float>(rng.Next() % (32*height)));
+		for (WalkPosition & w : WalkPositions)	w = WalkPosition(static_cast<float>(rng.Next() % (4*width)), static_cast<float>(rng.Next() % (4*height)));
+		for (TilePosition & t : TilePositions)	t = TilePosition(static_cast<float>(rng.Next() % width), static_cast<float>(rng.Next() % height));
+	}
+
+	vector<Position>				Positions;
+	vector<WalkPosition>			WalkPositions;
+	vector<TilePosition>			TilePositions;
+};
+
+
+uint64_t pathResult(const CPPath & Path, int length)
+{
+	uint64_t result = uint64_t(length) * 31 + Path.size();
+	for (const ChokePoint * cp : Path)
+		result = result * 31 + cp->Index();
+	return result;
+}
+
+
+uint64_t getPathQuery(const Map & theMap, const QueryPoints & Points, int i)
+{
+	int length;
+	const CPPath Path = theMap.GetPath(Points.Positions[2*i], Points.Positions[2*i + 1], &length);
+	return pathResult(Path, length);
+}
+
+
+uint64_t getNearestAreaQuery(const Map & theMap, const QueryPoints & Points, int i)
+{
+	const Area * area = theMap.GetNearestArea(Points.WalkPositions[i]);
+	return area ? area->Id() : 0;
+}
+
+
+uint64_t getGroundDistanceQuery(const Map & theMap, const QueryPoints & Points, int i)
+{
+	return uint64_t(theMap.GetGroundDistance(Points.Positions[2*i], Points.Positions[2*i + 1]));
+}
+
+
+// Runs GetPath, GetNearestArea and GetGroundDistance from several threads at the same time, each thread starting at a different query,
+// and counts the results that differ from the single threaded ones.
+int benchConcurrency(const Map & theMap, const QueryPoints & Points, const string & mapName, int queries, int threads)
+{
+	vector<uint64_t> Expected(3 * queries);
+	for (int i = 0 ; i < queries ; ++i)
+	{
+		Expected[3*i] = getPathQuery(theMap, Points, i);
+		Expected[3*i + 1] = getNearestAreaQuery(theMap, Points, i);
+		Expected[3*i + 2] = getGroundDistanceQuery(theMap, Points, i);
+	}
+
+	vector<int> Mismatches(threads, 0);
+	vector<thread> Threads;
+	const auto start = chrono::steady_clock::now();
+	for (int t = 0 ; t < threads ; ++t)
+		Threads.emplace_back([&, t]()
+		{
+			for (int k = 0 ; k < queries ; ++k)
+			{
+				const int i = (k + t * queries / threads) % queries;
+				if (getPathQuery(theMap, Points, i) != Expected[3*i]) ++Mismatches[t];
+				if (getNearestAreaQuery(theMap, Points, i) != Expected[3*i + 1]) ++Mismatches[t];
+				if (getGroundDistanceQuery(theMap, Points, i) != Expected[3*i + 2]) ++Mismatches[t];
+			}
+		});
+	for (thread & th : Threads) th.join();
+	const double totalMs = elapsedMilliseconds(start);
+
+	int mismatches = 0;
+	for (int m : Mismatches) mismatches += m;
+
+	printf("{\"bench\":\"Concurrency\",\"map\":\"%s\",\"threads\":%d,\"ops\":%d,\"totalMs\":%.3f,\"mismatches\":%d}\n",
+		mapName.c_str(), threads, 3 * queries * threads, totalMs, mismatches);
+	fflush(stdout);
+	return mismatches;
+}
+
+
+// Checks that the path from each ChokePoint to each other one is the reverse of the path back (Cf. ChokePoint::GetPathTo),
+// and returns the number of pairs where it is not.
+int checkReversePaths(const Map & theMap, const string & mapName)
+{
+	vector<const ChokePoint *> ChokePoints;
+	for (const Area & area : theMap.Areas())
+		ChokePoints.insert(ChokePoints.end(), area.ChokePoints().begin(), area.ChokePoints().end());
+	sort(ChokePoints.begin(), ChokePoints.end());
+	ChokePoints.erase(unique(ChokePoints.begin(), ChokePoints.end()), ChokePoints.end());
+
+	int pairs = 0;
+	int mismatches = 0;
+	for (const ChokePoint * a : ChokePoints)
+	for (const ChokePoint * b : ChokePoints)
+		if (a < b)
+		{
+			vector<const ChokePoint *> Path = a->GetPathTo(b).ToVector();
+			reverse(Path.begin(), Path.end());
+			if (Path != b->GetPathTo(a).ToVector()) ++mismatches;
+			++pairs;
+		}
+
+	printf("{\"bench\":\"ReversePaths\",\"map\":\"%s\",\"pairs\":%d,\"mismatches\":%d}\n", mapName.c_str(), pairs, mismatches);
+	fflush(stdout);
+	return mismatches;
+}
+
+
+// Compares each result of GetPaths (Cf. benchQueries) with the one of GetPath, and returns the number of queries where they differ.
+int checkBatchPaths(const Map & theMap, const QueryPoints & Points, const string & mapName, const vector<CPPath> & Paths, const vector<int> & Lengths)
+{
+	const int queries = int(Paths.size());
+	int mismatches = 0;
+	for (int i = 0 ; i < queries ; ++i)
+		if (pathResult(Paths[i], Lengths[i]) != getPathQuery(theMap, Points, i)) ++mismatches;
+
+	printf("{\"bench\":\"BatchPaths\",\"map\":\"%s\",\"queries\":%d,\"mismatches\":%d}\n", mapName.c_str(), queries, mismatches);
+	fflush(stdout);
+	return mismatches;
+}
+
+
+// Returns the number of mismatches found by checkBatchPaths, checkReversePaths and benchConcurrency.
+int benchQueries(const Map & theMap, const string & mapName, uint64_t seed, int queries, int threads)
+{
+	const QueryPoints Points(theMap, seed, queries);
+	const vector<TilePosition> & TilePositions = Points.TilePositions;
+
+	benchQuery("GetPath", mapName, queries, [&](int i) { return getPathQuery(theMap, Points, i); });
+
+	// The same queries as GetPath, answered by one call to GetPaths (made by the first op), so the checksums must be equal.
+	vector<Position> From(queries), To(queries);
+	for (int i = 0 ; i < queries ; ++i)
+	{
+		From[i] = Points.Positions[2*i];
+		To[i] = Points.Positions[2*i + 1];
+	}
+	vector<CPPath> Paths(queries);
+	vector<int> Lengths(queries);
+	benchQuery("GetPaths", mapName, queries, [&](int i) -> uint64_t
+	{
+		if (i == 0)
+			theMap.GetPaths(utils::Span<const Position>(From.data(), From.size()), utils::Span<const Position>(To.data(), To.size()),
+							utils::Span<CPPath>(Paths.data(), Paths.size()), utils::Span<int>(Lengths.data(), Lengths.size()));
+
+		return pathResult(Paths[i], Lengths[i]);
+	});
+	const int batchMismatches = checkBatchPaths(theMap, Points, mapName, Paths, Lengths);
+
+	benchQuery("GetNearestArea", mapName, queries, [&](int i) { return getNearestAreaQuery(theMap, Points, i); });
+
+	benchQuery("GetGroundDistance", mapName, queries, [&](int i) { return getGroundDistanceQuery(theMap, Points, i); });
+
+	TilePath Path;		// reused by all the queries, like a bot would do
+	benchQuery("GetTilePath", mapName, queries, [&](int i) -> uint64_t
+	{
+		const int length = theMap.GetTilePath(Points.Positions[2*i], Points.Positions[2*i + 1], Path);
+		return uint64_t(length) * 1024 + uint64_t(Path.size());
+	});
+
+	benchQuery("BreadthFirstSearch", mapName, queries, [&](int i) -> uint64_t
+	{
+		// Typical use: the nearest buildable Tile
+		TilePosition t = theMap.BreadthFirstSearch(TilePositions[i],
+			[](const Tile & tile, TilePosition) { return tile.Buildable(); },	// findCond
+			[](const Tile &, TilePosition) { return true; });					// visitCond
+		return uint64_t(t.x) * 1024 + uint64_t(t.y);
+	});
+
+	benchQuery("CanBuild", mapName, queries, [&](int i) -> uint64_t
+	{
+		// Typical use: can a 5x5 building be placed here?
+		const TileCoord topLeft(TilePositions[i]);
+		return uint64_t(theMap.CanBuild(topLeft, TileCoord(5, 5), theMap.GetArea(topLeft)));
+	});
+
+	// ExampleWall is much slower: one op computes the walls of all the ChokePoints.
+	benchQuery("ExampleWall", mapName, 1, [&](int) -> uint64_t
+	{
+		uint64_t walls = 0;
+		for (const ExampleWall & wall : findWalls(theMap, nullptr))
+			walls = walls * 31 + wall.Size();
+		return walls;
+	});
+
+	const int mismatches = batchMismatches + checkReversePaths(theMap, mapName);
+	return mismatches + (threads > 1 ? benchConcurrency(theMap, Points, mapName, queries, threads) : 0);
+}
+
+} // namespace
+
+
+int main(int argc, char * argv[])
+{
+	const Options options = parseOptions(argc, argv);
+	Map & theMap = Map::Instance();
+	int mismatches = 0;
+
+	try
+	{
+		for (int size : options.Sizes)
+		{
+			const string mapName = "synthetic-" + to_string(size);
+			SyntheticMapSource source(size, options.seed);
+			benchInitialize(theMap, source, mapName, options.reps);
+			mismatches += benchQueries(theMap, mapName, options.seed, options.queries, options.threads);
+		}
+
+		for (const string & fileName : options.Snapshots)
+		{
+			SnapshotMapSource source(fileName);
+			benchInitialize(theMap, source, fileName, options.reps);
+			mismatches += benchQueries(theMap, fileName, options.seed, options.queries, options.threads);
+		}
+	}
+	catch (const exception & e)
+	{
+		fprintf(stderr, "Sc2EMBench: %s\n", e.what());
+		return 1;
+	}
+
+	return mismatches ? 2 : 0;
+}
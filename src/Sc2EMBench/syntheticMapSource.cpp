@@ -0,0 +1,190 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is part of the BWEM Library.
+// BWEM is free software, licensed under the MIT/X11 License.
+// A copy of the license is provided with the library in the LICENSE file.
+// Copyright (c) 2015, 2017, Igor Dimitrijevic
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#include "syntheticMapSource.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+using namespace Sc2Bindings;
+
+using namespace std;
+
+
+namespace SC2EM {
+namespace bench {
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class SyntheticMapSource
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+
+SyntheticMapSource::SyntheticMapSource(int size, uint64_t seed)
+	: m_size(size), m_walkSize(4*size)
+{
+	Random rng(seed);
+	const float W = static_cast<float>(m_walkSize);
+	const int k = size >= 200 ? 4 : 3;		// rooms per row / column
+
+	// 1) Rooms and corridors (in MiniTiles):
+	for (int j = 0 ; j < k ; ++j)
+	for (int i = 0 ; i < k ; ++i)
+	{
+		Room room;
+		room.x = (i + 0.5f) * W / k + (rng.Uniform() - 0.5f) * W / k * 0.3f;
+		room.y = (j + 0.5f) * W / k + (rng.Uniform() - 0.5f) * W / k * 0.3f;
+		room.radius = W / k * (0.25f + 0.12f * rng.Uniform());
+		room.level = rng.Next() % 3;
+		m_Rooms.push_back(room);
+	}
+
+	for (int j = 0 ; j < k ; ++j)
+	for (int i = 0 ; i < k ; ++i)
+	{
+		const Room & a = m_Rooms[j*k + i];
+		if ((i + 1 < k) && (rng.Next() % 5))
+			m_Corridors.push_back(Corridor{a.x, a.y, m_Rooms[j*k + i+1].x, m_Rooms[j*k + i+1].y, 2.0f + rng.Next() % 8});
+		if ((j + 1 < k) && (rng.Next() % 5))
+			m_Corridors.push_back(Corridor{a.x, a.y, m_Rooms[(j+1)*k + i].x, m_Rooms[(j+1)*k + i].y, 2.0f + rng.Next() % 8});
+	}
+
+	vector<sc2::Point2D> Lakes;
+	for (const Room & room : m_Rooms)
+		if (rng.Next() % 2) Lakes.emplace_back(room.x + room.radius * 0.5f, room.y - room.radius * 0.3f);
+
+	// 2) Pathing and placement grids:
+	m_Pathable.resize(m_walkSize * m_walkSize);
+	m_Placable.resize(m_walkSize * m_walkSize);
+	for (int y = 0 ; y < m_walkSize ; ++y)
+	for (int x = 0 ; x < m_walkSize ; ++x)
+	{
+		bool pathable = false;
+		bool interior = false;
+		bool corridor = false;
+		for (const Room & room : m_Rooms)
+		{
+			const float d = hypot(x - room.x, y - room.y);
+			if (d < room.radius) pathable = true;
+			if (d < room.radius - 6) interior = true;
+		}
+
+		for (const Corridor & c : m_Corridors)
+		{
+			const float vx = c.x2 - c.x1;
+			const float vy = c.y2 - c.y1;
+			const float t = max(0.0f, min(1.0f, ((x - c.x1)*vx + (y - c.y1)*vy) / (vx*vx + vy*vy)));
+			if (hypot(x - (c.x1 + t*vx), y - (c.y1 + t*vy)) < c.halfWidth) pathable = corridor = true;
+		}
+
+		for (const sc2::Point2D & lake : Lakes)
+			if (hypot(x - lake.x, y - lake.y) < 4.5f) pathable = interior = false;
+
+		m_Pathable[y*m_walkSize + x] = pathable;
+		m_Placable[y*m_walkSize + x] = interior && !corridor;
+	}
+
+	// 3) Neutrals (in Tiles): a mineral line and 2 geysers in most rooms, rocks and mineral chunks in some corridors.
+	for (size_t r = 0 ; r < m_Rooms.size() ; ++r)
+	{
+		const float cx = m_Rooms[r].x / 4;
+		const float cy = m_Rooms[r].y / 4;
+		if ((r == 0) || (r + 1 == m_Rooms.size())) m_StartLocations.emplace_back(cx, cy);
+		if (r % 3 == 2) continue;
+
+		for (int i = 0 ; i < 8 ; ++i)
+		{
+			const float angle = 0.5f + i * 0.35f;
+			const float x = floor(cx + 7*cos(angle));
+			const float y = floor(cy + 7*sin(angle));
+			if (i < 6)	AddNeutral(sc2::UNIT_TYPEID::NEUTRAL_MINERALFIELD, x, y, 1, 1500, 0);
+			else		AddNeutral(sc2::UNIT_TYPEID::NEUTRAL_VESPENEGEYSER, x, y, 2, 2250, 2250);
+		}
+	}
+
+	for (size_t i = 0 ; i < m_Corridors.size() ; i += 3)
+	{
+		const Corridor & c = m_Corridors[i];
+		AddNeutral(sc2::UNIT_TYPEID::NEUTRAL_DESTRUCTIBLEROCK6X6, floor((c.x1 + c.x2) / 8), floor((c.y1 + c.y2) / 8), 3, 0, 0);
+	}
+
+	for (size_t i = 1 ; i < m_Corridors.size() ; i += 4)
+	{
+		const Corridor & c = m_Corridors[i];
+		AddNeutral(sc2::UNIT_TYPEID::NEUTRAL_MINERALFIELD, floor((c.x1 + c.x2) / 8) + 1, floor((c.y1 + c.y2) / 8), 1, 5, 0);
+	}
+}
+
+
+// Adds a neutral unit, unless it would not fit inside the map.
+void SyntheticMapSource::AddNeutral(sc2::UNIT_TYPEID type, float x, float y, float radius, int minerals, int vespene)
+{
+	if ((x - radius < 1) || (y - radius < 1) || (x + radius >= m_size - 1) || (y + radius >= m_size - 1)) return;
+
+	sc2::Unit u;
+	u.tag = m_NeutralUnits.size() + 1;
+	u.unit_type = type;
+	u.pos = sc2::Point3D(x, y, 0);
+	u.radius = radius;
+	u.mineral_contents = minerals;
+	u.vespene_contents = vespene;
+	u.alliance = sc2::Unit::Alliance::Neutral;
+	m_NeutralUnits.push_back(u);
+}
+
+
+int SyntheticMapSource::WalkIndex(const sc2::Point2D & p) const
+{
+	const int x = static_cast<int>(p.x);
+	const int y = static_cast<int>(p.y);
+	return (0 <= x) && (x < m_walkSize) && (0 <= y) && (y < m_walkSize) ? y*m_walkSize + x : -1;
+}
+
+
+bool SyntheticMapSource::IsPathable(const sc2::Point2D & p) const
+{
+	const int i = WalkIndex(p);
+	return (i >= 0) && m_Pathable[i];
+}
+
+
+bool SyntheticMapSource::IsPlacable(const sc2::Point2D & p) const
+{
+	const int i = WalkIndex(sc2::Point2D(4*floor(p.x) + 2, 4*floor(p.y) + 2));
+	return (i >= 0) && m_Placable[i];
+}
+
+
+// The ground height of the nearest room (x2), plus a doodad on some Tiles.
+float SyntheticMapSource::TerrainHeight(const sc2::Point2D & p) const
+{
+	const int x = 4*static_cast<int>(p.x);
+	const int y = 4*static_cast<int>(p.y);
+
+	int level = 0;
+	float bestDist = numeric_limits<float>::max();
+	for (const Room & room : m_Rooms)
+	{
+		const float d = hypot(x - room.x, y - room.y);
+		if (d < bestDist)
+		{
+			bestDist = d;
+			level = room.level;
+		}
+	}
+
+	return static_cast<float>(level*2 + ((x/4 + y/4) % 17 == 0));
+}
+
+
+}} // namespace SC2EM::bench
@@ -0,0 +1,89 @@
+//////////////////////////////////////////////////////////////////////////
+//
+// This file is part of the BWEM Library.
+// BWEM is free software, licensed under the MIT/X11 License.
+// A copy of the license is provided with the library in the LICENSE file.
+// Copyright (c) 2015, 2017, Igor Dimitrijevic
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+#ifndef BWEM_SYNTHETIC_MAP_SOURCE_H
+#define BWEM_SYNTHETIC_MAP_SOURCE_H
+
+#include "bwem.h"
+#include <vector>
+#include <cstdint>
+
+
+namespace SC2EM {
+namespace bench {
+
+
+// Small deterministic random generator (xorshift64), so that the synthetic maps do not depend on the standard library.
+class Random
+{
+public:
+	explicit							Random(uint64_t seed) : m_state(seed * 2654435761ull + 1) {}
+
+	uint32_t							Next()						{ m_state ^= m_state << 13; m_state ^= m_state >> 7; m_state ^= m_state << 17; return uint32_t(m_state); }
+
+	// Returns a number in [0, 1).
+	float								Uniform()					{ return (Next() % 100000) / 100000.0f; }
+
+private:
+	uint64_t							m_state;
+};
+
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                          //
+//                                  class SyntheticMapSource
+//                                                                                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+//
+// A MapSource describing a generated ladder-like map, used to benchmark the library without any game client:
+//	- a grid of round plateaus (rooms), each with its own ground height
+//	- corridors of various widths between neighbouring rooms
+//	- small lakes inside some rooms
+//	- a mineral line and 2 geysers in most rooms, and the starting locations in two opposite rooms
+//	- destructible rocks and small mineral chunks in some corridors (blocking neutrals)
+//
+// The same (size, seed) always gives the same map.
+//
+
+class SyntheticMapSource : public MapSource
+{
+public:
+										SyntheticMapSource(int size, uint64_t seed);
+
+	Sc2Bindings::TilePosition			Size() const override		{ return Sc2Bindings::TilePosition(static_cast<float>(m_size), static_cast<float>(m_size)); }
+	std::vector<sc2::Point2D>			StartLocations() const override	{ return m_StartLocations; }
+	bool								IsPathable(const sc2::Point2D & p) const override;
+	bool								IsPlacable(const sc2::Point2D & p) const override;
+	float								TerrainHeight(const sc2::Point2D & p) const override;
+	std::vector<sc2::Unit>				NeutralUnits() const override	{ return m_NeutralUnits; }
+
+private:
+	struct Room		{ float x, y, radius; int level; };
+	struct Corridor	{ float x1, y1, x2, y2, halfWidth; };
+
+	void								AddNeutral(sc2::UNIT_TYPEID type, float x, float y, float radius, int minerals, int vespene);
+	int									WalkIndex(const sc2::Point2D & p) const;
+
+	int									m_size;			// in Tiles
+	int									m_walkSize;		// in MiniTiles
+	std::vector<Room>					m_Rooms;
+	std::vector<Corridor>				m_Corridors;
+	std::vector<uint8_t>				m_Pathable;		// m_walkSize x m_walkSize
+	std::vector<uint8_t>				m_Placable;		// m_walkSize x m_walkSize
+	std::vector<sc2::Point2D>			m_StartLocations;
+	std::vector<sc2::Unit>				m_NeutralUnits;
+};
+
+
+}} // namespace SC2EM::bench
+
+
+#endif